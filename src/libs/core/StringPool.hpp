@@ -1,32 +1,74 @@
 #pragma once
 
-#include <vector>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <unordered_map>
 #include <string_view>
 #include <string>
 #include <inttypes.h>
 #include <Architecture.hpp>
 
+// Safe to intern from several threads at once
 class StringPool
 {
 public:
-    uint64_t intern(const std::string& str)
+    uint64_t intern(std::string_view str)
     {
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            auto it = map.find(str);
+            if (it != map.end()) return it->second;
+        }
+
+        std::unique_lock<std::shared_mutex> lock(mutex);
         auto it = map.find(str);
         if (it != map.end()) return it->second;
 
-        uint64_t id = static_cast<uint64_t>(storage.size());
-        storage.push_back(str);
-        map[str] = id;
+        uint64_t id = count;
+        const std::string& stored = slot(id, true) = std::string(str);
+        map.emplace(std::string_view(stored), id);
+        count++;
         return id;
     }
 
+    // like intern, but never adds the string
+    bool find(std::string_view str, uint64_t& id) const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = map.find(str);
+        if (it == map.end()) return false;
+        id = it->second;
+        return true;
+    }
+
+    // ids are only handed out after their string is stored and chunks never move,
+    // so this doesn't need the lock
     const std::string& lookup(uint64_t id) const
     {
-        return storage[id];
+        return const_cast<StringPool*>(this)->slot(id, false);
     }
 
 private:
-    std::unordered_map<std::string, uint64_t> map;
-    std::vector<std::string> storage;
-};
\ No newline at end of file
+    // chunk n holds 2^(n + firstChunkBits) strings
+    static constexpr unsigned firstChunkBits = 10;
+    static constexpr size_t maxChunks = 64 - firstChunkBits;
+
+    std::string& slot(uint64_t id, bool allocate)
+    {
+        uint64_t index = id + (1ULL << firstChunkBits);
+        unsigned bit = 63 - static_cast<unsigned>(__builtin_clzll(index));
+        unsigned chunk = bit - firstChunkBits;
+
+        if (allocate && !chunks[chunk])
+            chunks[chunk] = std::make_unique<std::string[]>(1ULL << bit);
+
+        return chunks[chunk][index - (1ULL << bit)];
+    }
+
+    mutable std::shared_mutex mutex;
+    std::unordered_map<std::string_view, uint64_t> map;
+    std::array<std::unique_ptr<std::string[]>, maxChunks> chunks;
+    uint64_t count = 0;
+};
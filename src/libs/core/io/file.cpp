@@ -2,10 +2,17 @@
 
 #include <Exception.hpp>
 #include <cstdio>
+#include <iostream>
+#include <sstream>
 
 #ifdef _WIN32
 #include <fcntl.h>
 #include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 std::istream* openIstream(const std::string& path, std::ios::openmode mode)
@@ -56,4 +63,66 @@ void deleteFile(const std::string& path)
 {
     if (std::remove(path.c_str()) != 0)
         throw Exception::IOError("Couldn't delete file " + path, -1, -1);
-}
\ No newline at end of file
+}
+
+InputBuffer::InputBuffer(const std::string& path)
+{
+    if (path == "-")
+    {
+        std::ostringstream content;
+        content << std::cin.rdbuf();
+        owned = content.str();
+        data = owned.data();
+        size = owned.size();
+        return;
+    }
+
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+        throw Exception::IOError("Couldn't open file " + path, -1, -1);
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+    {
+        void* map = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED)
+        {
+            close(fd);
+            data = static_cast<const char*>(map);
+            size = static_cast<size_t>(st.st_size);
+            mapped = true;
+            return;
+        }
+    }
+    close(fd);
+#endif
+
+    // fallback: read everything at once
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.is_open())
+        throw Exception::IOError("Couldn't open file " + path, -1, -1);
+
+    std::ostringstream content;
+    content << file.rdbuf();
+    owned = content.str();
+    data = owned.data();
+    size = owned.size();
+}
+
+std::unique_ptr<InputBuffer> InputBuffer::fromContent(std::string content)
+{
+    std::unique_ptr<InputBuffer> buffer(new InputBuffer());
+    buffer->owned = std::move(content);
+    buffer->data = buffer->owned.data();
+    buffer->size = buffer->owned.size();
+    return buffer;
+}
+
+InputBuffer::~InputBuffer()
+{
+#ifndef _WIN32
+    if (mapped)
+        munmap(const_cast<char*>(data), size);
+#endif
+}
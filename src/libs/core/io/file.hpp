@@ -1,11 +1,38 @@
 #pragma once
 
 #include <fstream>
+#include <memory>
 #include <string>
+#include <string_view>
 
 std::istream* openIstream(const std::string& path, std::ios::openmode mode = std::ios::in);
 std::ostream* openOstream(const std::string& path, std::ios::openmode mode = std::ios::out);
 void deleteFile(const std::string& path);
 
+// Whole input file in one contiguous buffer.
+// Regular files are memory-mapped, stdin ("-") and everything else is read at once.
+class InputBuffer
+{
+public:
+    explicit InputBuffer(const std::string& path);
+    ~InputBuffer();
+
+    // buffer over data that is already in memory (e.g. preprocessor output)
+    static std::unique_ptr<InputBuffer> fromContent(std::string content);
+
+    InputBuffer(const InputBuffer&) = delete;
+    InputBuffer& operator=(const InputBuffer&) = delete;
+
+    std::string_view view() const noexcept { return std::string_view(data, size); }
+
+private:
+    InputBuffer() = default;
+
+    const char* data = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+    std::string owned;
+};
+
 std::string getExecutablePath();
 std::string getExecutableDir();
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Read-only view of elements that live in an Arena
+template <typename T>
+struct Span
+{
+    const T* data = nullptr;
+    size_t count = 0;
+
+    const T* begin() const noexcept { return data; }
+    const T* end() const noexcept { return data + count; }
+    size_t size() const noexcept { return count; }
+    bool empty() const noexcept { return count == 0; }
+    const T& operator[](size_t index) const noexcept { return data[index]; }
+};
+
+// Bump allocator, everything is freed at once when the arena is destroyed.
+// Only meant for trivially destructible types, destructors are never run.
+class Arena
+{
+public:
+    explicit Arena(size_t _blockSize = 64 * 1024)
+        : blockSize(_blockSize) {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t size, size_t align)
+    {
+        uintptr_t address = reinterpret_cast<uintptr_t>(current);
+        size_t padding = (align - (address % align)) % align;
+
+        if (!current || padding + size > remaining)
+        {
+            // big allocations get their own block
+            size_t newSize = size + align > blockSize ? size + align : blockSize;
+            blocks.emplace_back(new unsigned char[newSize]);
+            current = blocks.back().get();
+            remaining = newSize;
+
+            address = reinterpret_cast<uintptr_t>(current);
+            padding = (align - (address % align)) % align;
+        }
+
+        unsigned char* result = current + padding;
+        current += padding + size;
+        remaining -= padding + size;
+        return result;
+    }
+
+    template <typename T>
+    Span<T> copy(const std::vector<T>& items)
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "Arena only holds trivially destructible types");
+
+        if (items.empty())
+            return Span<T>{};
+
+        T* data = static_cast<T*>(allocate(sizeof(T) * items.size(), alignof(T)));
+        std::uninitialized_copy(items.begin(), items.end(), data);
+        return Span<T>{data, items.size()};
+    }
+
+private:
+    size_t blockSize;
+    std::vector<std::unique_ptr<unsigned char[]>> blocks;
+    unsigned char* current = nullptr;
+    size_t remaining = 0;
+};
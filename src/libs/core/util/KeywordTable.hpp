@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+namespace KeywordTableDetail
+{
+    // ASCII only, like the keywords
+    constexpr char toLower(char c) noexcept
+    {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    // FNV-1a over the lowercased key
+    constexpr uint32_t hash(std::string_view key) noexcept
+    {
+        uint32_t h = 2166136261u;
+        for (char c : key)
+        {
+            h ^= static_cast<unsigned char>(toLower(c));
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    // power of two with a load factor of at most 1/2
+    constexpr size_t capacityFor(size_t n) noexcept
+    {
+        size_t capacity = 1;
+        while (capacity < n * 2) capacity <<= 1;
+        return capacity;
+    }
+}
+
+constexpr bool equalsIgnoreCase(std::string_view a, std::string_view b) noexcept
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++)
+        if (KeywordTableDetail::toLower(a[i]) != KeywordTableDetail::toLower(b[i])) return false;
+    return true;
+}
+
+// Case-insensitive string -> value table built at compile time.
+// Uses open addressing with linear probing, lookups don't allocate.
+template <typename T, size_t Capacity>
+class KeywordTable
+{
+public:
+    template <size_t N>
+    constexpr explicit KeywordTable(const std::pair<std::string_view, T> (&entries)[N])
+    {
+        static_assert(Capacity >= N * 2, "KeywordTable capacity too small");
+        for (const auto& entry : entries)
+        {
+            size_t index = KeywordTableDetail::hash(entry.first) & (Capacity - 1);
+            while (slots[index].used)
+            {
+                if (equalsIgnoreCase(slots[index].key, entry.first))
+                    throw "Duplicate key in KeywordTable"; // compile time error
+                index = (index + 1) & (Capacity - 1);
+            }
+            slots[index].key = entry.first;
+            slots[index].value = entry.second;
+            slots[index].used = true;
+        }
+    }
+
+    // returns nullptr if the key doesn't exist
+    constexpr const T* find(std::string_view key) const noexcept
+    {
+        size_t index = KeywordTableDetail::hash(key) & (Capacity - 1);
+        while (slots[index].used)
+        {
+            if (equalsIgnoreCase(slots[index].key, key))
+                return &slots[index].value;
+            index = (index + 1) & (Capacity - 1);
+        }
+        return nullptr;
+    }
+
+    constexpr bool contains(std::string_view key) const noexcept
+    {
+        return find(key) != nullptr;
+    }
+
+private:
+    struct Slot
+    {
+        std::string_view key;
+        T value{};
+        bool used = false;
+    };
+
+    std::array<Slot, Capacity> slots{};
+};
+
+template <typename T, size_t N>
+constexpr auto makeKeywordTable(const std::pair<std::string_view, T> (&entries)[N])
+{
+    return KeywordTable<T, KeywordTableDetail::capacityFor(N)>(entries);
+}
@@ -17,9 +17,9 @@ std::string trim(const std::string& str)
 }
 
 // turn strings lowercase
-std::string toLower(const std::string& input)
+std::string toLower(std::string_view input)
 {
-    std::string result = input;  // Kopiere den Input
+    std::string result(input);  // Kopiere den Input
     std::transform(result.begin(), result.end(), result.begin(),
                    [](unsigned char c) { return std::tolower(c); });
     return result;
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <string_view>
 
 std::string trim(const std::string& str);
-std::string toLower(const std::string& input);
\ No newline at end of file
+std::string toLower(std::string_view input);
\ No newline at end of file
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <unordered_map>
+#include <util/KeywordTable.hpp>
 #include <string_view>
 #include <cstdint>
 
@@ -68,7 +68,8 @@ namespace x86
         XCR0, PKRU
     };
 
-    static const std::unordered_map<std::string_view, Registers> registers = {
+    // case-insensitive
+    inline constexpr auto registers = makeKeywordTable<Registers>({
         {"al", AL}, {"bl", BL}, {"cl", CL}, {"dl", DL},
         {"ah", AH}, {"bh", BH}, {"ch", CH}, {"dh", DH},
         {"spl", SPL}, {"bpl", BPL}, {"sil", SIL}, {"dil", DIL},
@@ -175,5 +176,5 @@ namespace x86
 
         // other
         {"xcr0", XCR0}, {"pkru", PKRU}
-    };
+    });
 }
\ No newline at end of file
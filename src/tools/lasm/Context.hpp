@@ -8,4 +8,7 @@ struct Context
     WarningManager* warningManager;
     std::string filename;
     StringPool* stringPool;
+
+    // --sparse, zero blocks of flat binaries are left as holes
+    bool sparseOutput = false;
 };
\ No newline at end of file
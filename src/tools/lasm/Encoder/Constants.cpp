@@ -3,143 +3,200 @@
 
 void Encoder::Encoder::resolveConstants(bool withPos)
 {
-    std::unordered_set<std::string> visited;
-    
-    for (auto& [name, constant] : constants)
+    for (uint32_t index : constantOrder)
     {
-        if (!constant.resolved)
+        Constant& c = constants[index];
+        if (c.resolved) continue;
+
+        if (!withPos)
         {
-            if (withPos)
-                resolveConstantWithPos(constant, visited);
-            else
-                resolveConstantWithoutPos(constant, visited);
+            if (c.hasPos == HasPos::TRUE) continue;
+
+            // anything that uses a label, directly or through another constant, has to wait for the layout
+            bool needsPos = c.dependsOnLabel;
+            for (size_t i = 0; i < c.dependencyCount && !needsPos; i++)
+                needsPos = !constants[constantDependencies[c.firstDependency + i]].resolved;
+
+            if (needsPos)
+            {
+                c.hasPos = HasPos::TRUE;
+                continue;
+            }
         }
+
+        resolveConstant(c, withPos);
     }
 }
 
+Encoder::Label* Encoder::Encoder::findLabel(uint64_t name)
+{
+    const Symbol symbol = symbolTable.find(name);
+    return symbol.kind == SymbolKind::Label ? &labels[symbol.index] : nullptr;
+}
+
+Encoder::Constant* Encoder::Encoder::findConstant(uint64_t name)
+{
+    const Symbol symbol = symbolTable.find(name);
+    return symbol.kind == SymbolKind::Constant ? &constants[symbol.index] : nullptr;
+}
+
 bool Encoder::Encoder::Resolvable(const Parser::Immediate& immediate)
 {
-    for (const auto& dep : getDependencies(immediate))
+    for (const Parser::ExpressionToken& token : immediate.rpn)
     {
-        auto itLabel = labels.find(dep);
-        if (itLabel != labels.end())
-            if (!itLabel->second.resolved) return false;
+        if (token.type != Parser::ExpressionToken::Type::String) continue;
 
-        auto itConstant = constants.find(dep);
-        if (itConstant != constants.end())
-            if (!itConstant->second.resolved) return false;
+        const Symbol symbol = symbolTable.find(token.value);
+        if (symbol.kind == SymbolKind::Label && !labels[symbol.index].resolved) return false;
+        if (symbol.kind == SymbolKind::Constant && !constants[symbol.index].resolved) return false;
     }
     return true;
 }
 
-std::vector<std::string> Encoder::Encoder::getDependencies(const Parser::Immediate& immediate)
+bool Encoder::Encoder::Resolvable(const Parser::Instruction::Instruction& instruction)
 {
-    std::vector<std::string> deps;
-    for (const auto& operand : immediate.operands)
-    {
-        if (std::holds_alternative<Parser::String>(operand))
-        {
-            const Parser::String& str = std::get<Parser::String>(operand);
-            deps.push_back(str.value);
-        }
-    }
-    return deps;
+    for (const auto& operand : instruction.operands)
+        if (std::holds_alternative<Parser::Immediate>(operand) && !Resolvable(std::get<Parser::Immediate>(operand)))
+            return false;
+    return true;
 }
 
-bool Encoder::Encoder::resolveConstantWithoutPos(Constant& c, std::unordered_set<std::string>& visited)
+bool Encoder::Encoder::Resolvable(const Parser::DataDefinition& dataDefinition)
 {
-    if (c.resolved) return true;
-    if (c.hasPos == HasPos::TRUE) return false;
+    for (const auto& value : dataDefinition.values)
+        if (!Resolvable(value))
+            return false;
+    return true;
+}
 
-    if (visited.count(c.name))
-        throw Exception::SemanticError("Circular dependency at " + c.name, -1, -1); // FIXME: no line or column
-    visited.insert(c.name);
+// Edges go from a constant to the constants its expression uses. Built once, after that
+// resolving is a single walk over constantOrder instead of a recursion per constant.
+void Encoder::Encoder::buildConstantGraph()
+{
+    const size_t count = constants.size();
 
-    for (const auto& dep : getDependencies(c.expression))
+    constantDependencies.clear();
+    std::vector<size_t> users(count + 1, 0);
+    for (Constant& c : constants)
     {
-        if (labels.count(dep))
-        {
-            c.hasPos = HasPos::TRUE;
-            visited.erase(c.name);
-            return false;
-        }
-
-        auto it = constants.find(dep);
-        if (it == constants.end())
-            throw Exception::InternalError("Unknown dependency: " + dep, -1, -1);
+        c.firstDependency = constantDependencies.size();
+        c.dependencyCount = 0;
+        c.dependsOnLabel = false;
 
-        if (!resolveConstantWithoutPos(it->second, visited))
+        for (const Parser::ExpressionToken& token : c.expression.rpn)
         {
-            c.hasPos = HasPos::TRUE;
-            visited.erase(c.name);
-            return false;
+            if (token.type != Parser::ExpressionToken::Type::String) continue;
+
+            const Symbol symbol = symbolTable.find(token.value);
+            if (symbol.kind == SymbolKind::Label)
+            {
+                c.dependsOnLabel = true;
+                continue;
+            }
+            if (symbol.kind != SymbolKind::Constant)
+                throw Exception::SemanticError("Unknown symbol '" + context.stringPool->lookup(token.value) + "' in constant '" + c.name + "'", c.lineNumber, c.column);
+
+            constantDependencies.push_back(symbol.index);
+            c.dependencyCount++;
+            users[symbol.index + 1]++;
         }
     }
 
-    Evaluation evaluated = Evaluate(c.expression, 0, 0, &c.section);
-    if (evaluated.relocationPossible) c.relocationPossible = true;
-    if (evaluated.relocationPossible && evaluated.useOffset)
+    // reversed edges, for each constant the ones using it
+    for (size_t i = 0; i < count; i++)
+        users[i + 1] += users[i];
+    std::vector<uint32_t> userList(constantDependencies.size());
+    std::vector<size_t> fill(users.begin(), users.end() - 1);
+    for (size_t i = 0; i < count; i++)
+        for (size_t d = 0; d < constants[i].dependencyCount; d++)
+            userList[fill[constantDependencies[constants[i].firstDependency + d]]++] = static_cast<uint32_t>(i);
+
+    // Kahn's algorithm, ties keep the order of definition
+    std::vector<size_t> pending(count);
+    constantOrder.clear();
+    constantOrder.reserve(count);
+    for (size_t i = 0; i < count; i++)
     {
-        c.useOffset = true;
-        c.off = evaluated.offset;
-        c.usedSection = evaluated.usedSection;
+        pending[i] = constants[i].dependencyCount;
+        if (pending[i] == 0)
+            constantOrder.push_back(static_cast<uint32_t>(i));
     }
-    else
+
+    for (size_t next = 0; next < constantOrder.size(); next++)
     {
-        const Int128& value = evaluated.result;
+        const uint32_t node = constantOrder[next];
+        for (size_t u = users[node]; u < users[node + 1]; u++)
+            if (--pending[userList[u]] == 0)
+                constantOrder.push_back(userList[u]);
+    }
 
-        if (value < static_cast<Int128>(std::numeric_limits<int64_t>::min()) ||
-            value > static_cast<Int128>(std::numeric_limits<int64_t>::max()))
-            throw Exception::OverflowError("Constant '" + c.name + "' too big for a signed 64-bit integer", -1, -1); // FIXME: no line or column
-        c.value = static_cast<int64_t>(value);
+    if (constantOrder.size() == count)
+        return;
+
+    // Whatever is left is on a cycle or depends on one. Every one of them still has an unresolved
+    // dependency, so following those has to come back to a constant already seen.
+    size_t node = 0;
+    while (pending[node] == 0) node++;
+
+    std::vector<size_t> seenAt(count, std::numeric_limits<size_t>::max());
+    std::vector<size_t> path;
+    while (seenAt[node] == std::numeric_limits<size_t>::max())
+    {
+        seenAt[node] = path.size();
+        path.push_back(node);
+
+        const Constant& c = constants[node];
+        for (size_t d = 0; d < c.dependencyCount; d++)
+        {
+            const uint32_t dep = constantDependencies[c.firstDependency + d];
+            if (pending[dep] != 0)
+            {
+                node = dep;
+                break;
+            }
+        }
     }
-    c.resolved = true;
-    c.prePass = true;
 
-    c.hasPos = HasPos::FALSE;
-    visited.erase(c.name);
-    return true;
+    std::string cycle;
+    for (size_t i = seenAt[node]; i < path.size(); i++)
+        cycle += constants[path[i]].name + " -> ";
+    cycle += constants[node].name;
+
+    const Constant& first = constants[node];
+    throw Exception::SemanticError("Circular dependency: " + cycle, first.lineNumber, first.column);
 }
 
-bool Encoder::Encoder::resolveConstantWithPos(Constant& c, std::unordered_set<std::string>& visited)
+void Encoder::Encoder::resolveConstant(Constant& c, bool withPos)
 {
-    if (c.resolved) return true;
-    
-    if (visited.count(c.name))
-        throw Exception::SemanticError("Circular dependency at " + c.name, -1, -1); // FIXME: no line or column
-    visited.insert(c.name);
+    Evaluation evaluated = withPos
+        ? Evaluate(c.expression, c.bytesWritten, c.offset, &c.section)
+        : Evaluate(c.expression, 0, 0, &c.section);
 
-    for (const auto& dep : getDependencies(c.expression))
-    {
-        if (labels.count(dep)) continue;
-        
-        auto it = constants.find(dep);
-        if (it == constants.end())
-            throw Exception::InternalError("Unknown dependency: " + dep, -1, -1);
-
-        if (!resolveConstantWithPos(it->second, visited))
-            throw Exception::InternalError("Couldn't resolve constant '" + dep + "'", -1, -1);
-    }
+    // a constant has no place of its own to be relative to
+    const bool relocatable = evaluated.relocationPossible && !evaluated.pcRelative;
 
-    Evaluation evaluated = Evaluate(c.expression, c.bytesWritten, c.offset, &c.section);
-    if (evaluated.relocationPossible) c.relocationPossible = true;
-    if (evaluated.relocationPossible && evaluated.useOffset)
+    if (relocatable) c.relocationPossible = true;
+    if (relocatable && evaluated.useOffset)
     {
         c.useOffset = true;
         c.off = evaluated.offset;
         c.usedSection = evaluated.usedSection;
+        c.usedExtern = evaluated.isExtern;
     }
     else
     {
         const Int128& value = evaluated.result;
-    
+
         if (value < static_cast<Int128>(std::numeric_limits<int64_t>::min()) ||
             value > static_cast<Int128>(std::numeric_limits<int64_t>::max()))
-            throw Exception::OverflowError("Constant '" + c.name + "' too big for a signed 64-bit integer", -1, -1); // FIXME: no line or column
+            throw Exception::OverflowError("Constant '" + c.name + "' too big for a signed 64-bit integer", c.lineNumber, c.column);
         c.value = static_cast<int64_t>(value);
     }
     c.resolved = true;
 
-    visited.erase(c.name);
-    return true;
-}
\ No newline at end of file
+    if (!withPos)
+    {
+        c.prePass = true;
+        c.hasPos = HasPos::FALSE;
+    }
+}
@@ -1,16 +1,20 @@
 #include "Encoder.hpp"
 
-std::vector<uint8_t> Encoder::Encoder::EncodeData(const Parser::DataDefinition& dataDefinition)
+void Encoder::Encoder::EncodeData(const Parser::DataDefinition& dataDefinition, SectionBuffer& out, bool ignoreUnresolved)
 {
     // TODO: placeholder implementation
     if(!dataDefinition.reserved)
     {
         size_t size = dataDefinition.size * dataDefinition.values.size();
-        std::vector<uint8_t> buffer;
-        buffer.reserve(size);
+        if (ignoreUnresolved)
+        {
+            out.resize(out.size() + size, 0);
+            return;
+        }
 
-        for (const auto& value : dataDefinition.values)
+        for (size_t index = 0; index < dataDefinition.values.size(); index++)
         {
+            const Parser::Immediate& value = dataDefinition.values[index];
             if (value.operands.empty())
                 throw Exception::SemanticError("Data definition cannot be empty", dataDefinition.lineNumber, dataDefinition.column);
 
@@ -18,18 +22,13 @@ std::vector<uint8_t> Encoder::Encoder::EncodeData(const Parser::DataDefinition&
 
             if (evaluated.useOffset)
             {
+                // $ is the start of the line, but every value has its own field
+                Relocation reloc = makeRelocation(evaluated, sectionOffset + index * dataDefinition.size, *currentSection);
                 for (size_t i = 0; i < dataDefinition.size; i++)
                 {
-                    uint8_t byte = static_cast<uint8_t>((evaluated.offset >> (i * 8)) & 0xFF);
-                    buffer.push_back(byte);
+                    uint8_t byte = static_cast<uint8_t>((reloc.addend >> (i * 8)) & 0xFF);
+                    out.push_back(byte);
                 }
-                Relocation reloc;
-                reloc.offsetInSection = sectionOffset;
-                reloc.addend = evaluated.offset;
-                reloc.addendInCode = true;
-                reloc.section = *currentSection;
-                reloc.usedSection = evaluated.usedSection;
-                reloc.type = RelocationType::Absolute;
                 switch (dataDefinition.size)
                 {
                     case 1: reloc.size = RelocationSize::Bit8; break;
@@ -45,27 +44,13 @@ std::vector<uint8_t> Encoder::Encoder::EncodeData(const Parser::DataDefinition&
                 for (size_t i = 0; i < dataDefinition.size; i++)
                 {
                     uint8_t byte = static_cast<uint8_t>((evaluated.result >> (i * 8)) & 0xFF);
-                    buffer.push_back(byte);
+                    out.push_back(byte);
                 }
             }
         }
-        return buffer;
     }
     else
     {
         throw Exception::InternalError("Reserved data encoding is not implemented yet", dataDefinition.lineNumber, dataDefinition.column);
     }
 }
-
-uint64_t Encoder::Encoder::GetSize(const Parser::DataDefinition& dataDefinition)
-{
-    if(!dataDefinition.reserved)
-    {
-        size_t size = dataDefinition.size * dataDefinition.values.size();
-        return size;
-    }
-    else
-    {
-        throw Exception::InternalError("Reserved data encoding is not implemented yet", dataDefinition.lineNumber, dataDefinition.column);
-    }
-}
\ No newline at end of file
@@ -1,5 +1,9 @@
 #include "Encoder.hpp"
 #include <limits>
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
 
 size_t Encoder::Section::size() const
 {
@@ -13,24 +17,44 @@ Encoder::Encoder::Encoder(const Context& _context, Architecture _arch, BitMode _
 
 }
 
+Encoder::Encoder::Encoder(Encoder* owner)
+    : context(owner->context), arch(owner->arch), bits(owner->bits), parser(owner->parser),
+      sectionStarts(owner->sectionStarts), symbolTable(owner->symbolTable), labels(owner->labels), constants(owner->constants),
+      constantOrder(owner->constantOrder), constantDependencies(owner->constantDependencies), symbols(owner->symbols),
+      worker(true)
+{
+
+}
+
 void Encoder::Encoder::Encode()
 {
     std::vector<Parser::Section> parsedSections = parser->getSections();
 
     ResolveConstantsPrePass(parsedSections);
 
-    if (OptimizeOffsets(parsedSections))
-        GetOffsets(parsedSections);
-
-    // resolve constant that haven't been resolved yet
-    resolveConstants(true);
+    OptimizeOffsets(parsedSections);
 
     relocations.clear();
     EncodeFinal(parsedSections);
+
+    // every label has its offset now, resolve constant that haven't been resolved yet
+    resolveConstants(true);
+
+    ApplyFixups();
+    IndexRelocations();
 }
 
 void Encoder::Encoder::ResolveConstantsPrePass(const std::vector<Parser::Section>& parsedSections)
 {
+    // every label and constant gets a slot, the table only grows once
+    size_t symbolCount = 0;
+    for (const auto& section : parsedSections)
+        for (const Parser::SectionEntry& entry : section.entries)
+            if (std::holds_alternative<Parser::Label>(entry) || std::holds_alternative<Parser::Constant>(entry))
+                symbolCount++;
+    symbolTable.reserve(symbolCount);
+    symbols.reserve(symbolCount);
+
     for (const auto& section : parsedSections)
     {
         for (size_t i = 0; i < section.entries.size(); i++)
@@ -41,15 +65,16 @@ void Encoder::Encoder::ResolveConstantsPrePass(const std::vector<Parser::Section
             {
                 const Parser::Label& label = std::get<Parser::Label>(entry);
                 Label lbl;
-                lbl.name = label.name;
+                lbl.name = context.stringPool->lookup(label.name);
                 lbl.section = section.name;
                 lbl.resolved = false;
                 lbl.isGlobal = label.isGlobal;
                 lbl.isExtern = label.isExtern;
-                if (labels.find(lbl.name) == labels.end())
+                const Symbol symbol = { SymbolKind::Label, static_cast<uint32_t>(labels.size()) };
+                if (symbolTable.insert(label.name, symbol))
                 {
-                    labels[lbl.name] = lbl;
-                    symbols.push_back(&labels[lbl.name]);
+                    labels.push_back(std::move(lbl));
+                    symbols.push_back(symbol);
                 }
                 else
                     throw Exception::SemanticError("Label '" + lbl.name + "' already defined", label.lineNumber, label.column);
@@ -58,220 +83,448 @@ void Encoder::Encoder::ResolveConstantsPrePass(const std::vector<Parser::Section
             {
                 const Parser::Constant& constant = std::get<Parser::Constant>(entry);
                 Constant c;
-                c.name = constant.name;
+                c.name = context.stringPool->lookup(constant.name);
                 c.section = section.name;
                 c.expression = constant.value;
                 c.resolved = false;
                 c.hasPos = constant.hasPos ? HasPos::TRUE : HasPos::UNKNOWN;
                 c.isGlobal = constant.isGlobal;
-                if (constants.find(constant.name) == constants.end())
+                c.lineNumber = constant.lineNumber;
+                c.column = constant.column;
+                const Symbol symbol = { SymbolKind::Constant, static_cast<uint32_t>(constants.size()) };
+                if (symbolTable.insert(constant.name, symbol))
                 {
-                    constants[constant.name] = c;
-                    symbols.push_back(&constants[constant.name]);
+                    constants.push_back(std::move(c));
+                    symbols.push_back(symbol);
                 }
                 else
-                    throw Exception::SemanticError("Constant '" + constant.name + "' already defined", constant.lineNumber, constant.column);
+                    throw Exception::SemanticError("Constant '" + c.name + "' already defined", constant.lineNumber, constant.column);
             }
         }
     }
 
+    buildConstantGraph();
+
     // resolve constant that don't use labels, $ or $$
     resolveConstants(false);
 }
 
-void Encoder::Encoder::GetOffsets(std::vector<Parser::Section>& parsedSections)
+void Encoder::Encoder::EncodeFinal(std::vector<Parser::Section>& parsedSections)
 {
     bytesWritten = 0;
-    for (Parser::Section& section : parsedSections)
+    if (EncodeSectionsInParallel(parsedSections))
+        return;
+
+    for (size_t s = 0; s < parsedSections.size(); s++)
+    {
+        Parser::Section& section = parsedSections[s];
+        EncodeSection(section, s < sectionSizes.size() ? sectionSizes[s] : MinimumSize(section));
+    }
+}
+
+void Encoder::Encoder::EncodeSection(Parser::Section& section, uint64_t sizeHint)
+{
+    Section sec;
+    sec.name = section.name;
+    sec.isInitialized = true;
+    sec.align = section.align;
+    if (section.name.compare(".bss") == 0)
     {
+        sec.isInitialized = false;
+    }
+    const bool isCode = section.name.compare(".text") == 0;
+
+    // grow the buffer once instead of with every entry
+    if (sec.isInitialized)
+        sec.buffer.reserve(sizeHint);
+
+    // workers start where the layout put the section
+    if (!worker)
         sectionStarts[section.name] = bytesWritten;
-        currentSection = &section.name;
-        sectionOffset = 0;
-        for (size_t i = 0; i < section.entries.size(); i++)
+    currentSection = &section.name;
+    sectionOffset = 0;
+
+    for (size_t i = 0; i < section.entries.size(); i++)
+    {
+        Parser::SectionEntry& entry = section.entries[i];
+        
+        if (std::holds_alternative<Parser::Instruction::Instruction>(entry) || std::holds_alternative<Parser::DataDefinition>(entry))
         {
-            Parser::SectionEntry& entry = section.entries[i];
-            
-            if (std::holds_alternative<Parser::Instruction::Instruction>(entry))
-            {
-                Parser::Instruction::Instruction& instruction = std::get<Parser::Instruction::Instruction>(entry);
-                const uint64_t size = GetSize(instruction);
-                
-                sectionOffset += size;
-                bytesWritten += size;
-            }
-            else if (std::holds_alternative<Parser::DataDefinition>(entry))
+            EncodeEntry(entry, sec);
+        }
+        else if (std::holds_alternative<Parser::Label>(entry))
+        {
+            const Parser::Label& label = std::get<Parser::Label>(entry);
+            if (Label* lbl = findLabel(label.name))
             {
-                const Parser::DataDefinition& dataDefinition = std::get<Parser::DataDefinition>(entry);
-                const uint64_t size = GetSize(dataDefinition);
-
-                sectionOffset += size;
-                bytesWritten += size;
+                if (worker)
+                    matchesLayout &= lbl->resolved && lbl->offset == sectionOffset;
+                else
+                {
+                    lbl->offset = sectionOffset;
+                    lbl->resolved = true;
+                }
             }
-            else if (std::holds_alternative<Parser::Label>(entry))
+            else
+                throw Exception::InternalError("Label '" + context.stringPool->lookup(label.name) + "' isn't found in constants", label.lineNumber, label.column);
+        }
+        else if (std::holds_alternative<Parser::Constant>(entry))
+        {
+            const Parser::Constant& constant = std::get<Parser::Constant>(entry);
+            if (Constant* c = findConstant(constant.name))
             {
-                const Parser::Label& label = std::get<Parser::Label>(entry);
-                auto it = labels.find(label.name);
-                if (it != labels.end())
+                if (worker)
+                    matchesLayout &= c->offset == sectionOffset && c->bytesWritten == bytesWritten;
+                else
                 {
-                    Label& lbl = it->second;
-                    lbl.offset = sectionOffset;
-                    lbl.resolved = true;
+                    c->offset = sectionOffset;
+                    c->bytesWritten = bytesWritten;
                 }
-                else
-                    throw Exception::InternalError("Label '" + label.name + "' isn't found in constants", label.lineNumber, label.column);
             }
-            else if (std::holds_alternative<Parser::Constant>(entry))
+            else
+                throw Exception::InternalError("Constant '" + context.stringPool->lookup(constant.name) + "' isn't found in constants", constant.lineNumber, constant.column);
+        }
+        else if (std::holds_alternative<Parser::Repetition>(entry))
+        {
+            const Parser::Repetition& repetition = std::get<Parser::Repetition>(entry);
+            if (!Resolvable(repetition.count))
+                throw Exception::SemanticError("Repetition count can't use symbols defined later", repetition.lineNumber, repetition.column);
+
+            const Evaluation countEval = Evaluate(repetition.count, bytesWritten, sectionOffset, currentSection);
+            const Int128& count128 = countEval.result;
+
+            if (count128 < 0)
+                throw Exception::SemanticError("Repetition count can't be negative", repetition.lineNumber, repetition.column);
+            
+            if (count128 > std::numeric_limits<uint64_t>::max())
+                throw Exception::InternalError("Repetition count to large for unsigned 64-bit integer", repetition.lineNumber, repetition.column);
+
+            const uint64_t count = static_cast<uint64_t>(count128);
+
+            for (const Parser::ExpressionToken& token : repetition.count.rpn)
             {
-                const Parser::Constant& constant = std::get<Parser::Constant>(entry);
-                auto it = constants.find(constant.name);
-                if (it != constants.end())
+                if (token.type == Parser::ExpressionToken::Type::String)
                 {
-                    Constant c = it->second;
-                    c.offset = sectionOffset;
-                    c.bytesWritten = bytesWritten;
-
-                    constants[constant.name] = c;
+                    repetitionChecks.push_back({&repetition, count, bytesWritten, sectionOffset, currentSection});
+                    break;
                 }
-                else
-                    throw Exception::InternalError("Constant '" + constant.name + "' isn't found in constants", constant.lineNumber, constant.column);
             }
-            else if (std::holds_alternative<Parser::Repetition>(entry))
+
+            if (i + 1 >= section.entries.size() || !(std::holds_alternative<Parser::Instruction::Instruction>(section.entries[i + 1])
+                                                  || std::holds_alternative<Parser::DataDefinition>(section.entries[i + 1])))
+                throw Exception::SemanticError("Only instructions and data can be repeated", repetition.lineNumber, repetition.column);
+
+            Parser::SectionEntry& repeated = section.entries[++i];
+            if (count == 0) continue;
+
+            // every copy sees a different '$', those have to be encoded one by one
+            if (UsesPosition(repeated))
             {
-                const Parser::Repetition& repetition = std::get<Parser::Repetition>(entry);
-                const Evaluation countEval = Evaluate(repetition.count, bytesWritten, sectionOffset, currentSection);
-                const Int128& count128 = countEval.result;
-
-                if (count128 < 0)
-                    throw Exception::SemanticError("Repetition count can't be negative", repetition.lineNumber, repetition.column);
-                
-                if (count128 > std::numeric_limits<uint64_t>::max())
-                    throw Exception::InternalError("Repetition count to large for unsigned 64-bit integer", repetition.lineNumber, repetition.column);
-
-                const uint64_t count = static_cast<uint64_t>(count128);
-                // TODO
+                for (uint64_t n = 0; n < count; n++)
+                    EncodeEntry(repeated, sec);
             }
-            else if (std::holds_alternative<Parser::Alignment>(entry))
+            else
+                RepeatEntry(repeated, sec, count, repetition.lineNumber, repetition.column);
+        }
+        else if (std::holds_alternative<Parser::Alignment>(entry))
+        {
+            const Parser::Alignment& alignment = std::get<Parser::Alignment>(entry);
+            const Evaluation alignEval = Evaluate(alignment.align, bytesWritten, sectionOffset, currentSection);
+            const Int128& align = alignEval.result;
+            
+            if (align <= 0)
+                throw Exception::SemanticError("Alignment cannot be zero or lower", alignment.lineNumber, alignment.column);
+            
+            const Int128 offset128 = static_cast<Int128>(sectionOffset);
+            const Int128 padding128 = (align - (offset128 % align)) % align;
+            if (padding128 > std::numeric_limits<size_t>::max())
+                throw Exception::InternalError("Padding too large for size_t", alignment.lineNumber, alignment.column);
+
+            const size_t padding = static_cast<size_t>(padding128);
+            if (padding > 0)
             {
-                const Parser::Alignment& alignment = std::get<Parser::Alignment>(entry);
-                const Evaluation alignEval = Evaluate(alignment.align, bytesWritten, sectionOffset, currentSection);
-                const Int128& align = alignEval.result;
+                // data is padded with zeros, only code has to stay executable
+                if (!sec.isInitialized)
+                    sec.reservedSize += padding;
+                else if (isCode)
+                    EncodePadding(sec.buffer, padding, alignment.bits);
+                else
+                    sec.buffer.resize(sec.buffer.size() + padding, 0);
 
-                if (align <= 0)
-                    throw Exception::SemanticError("Alignment cannot be zero or lower", alignment.lineNumber, alignment.column);
+                sectionOffset += padding;
+                bytesWritten += padding;
+            }
+        }  
+    }
 
-                const Int128 offset128 = static_cast<Int128>(sectionOffset);
-                const Int128 padding128 = (align - (offset128 % align)) % align;
-                if (padding128 > std::numeric_limits<uint64_t>::max())
-                    throw Exception::InternalError("Padding too large for unsigned 64-bit integer", alignment.lineNumber, alignment.column);
+    sections.push_back(std::move(sec));
+}
 
-                const uint64_t padding = static_cast<uint64_t>(padding128);
-                if (padding > 0)
-                {
-                    sectionOffset += padding;
-                    bytesWritten += padding;
-                }
-            }  
+uint64_t Encoder::Encoder::MinimumSize(const Parser::Section& section)
+{
+    using Type = Parser::ExpressionToken::Type;
+
+    uint64_t size = 0;
+    for (size_t i = 0; i < section.entries.size(); i++)
+    {
+        const Parser::SectionEntry& entry = section.entries[i];
+        if (std::holds_alternative<Parser::Instruction::Instruction>(entry))
+            size++;
+        else if (std::holds_alternative<Parser::DataDefinition>(entry))
+        {
+            const Parser::DataDefinition& dataDefinition = std::get<Parser::DataDefinition>(entry);
+            if (!dataDefinition.reserved)
+                size += dataDefinition.size * dataDefinition.values.size();
+        }
+        else if (std::holds_alternative<Parser::Repetition>(entry) && i + 1 < section.entries.size()
+              && std::holds_alternative<Parser::DataDefinition>(section.entries[i + 1]))
+        {
+            // only plain numbers, anything else is sized while encoding
+            const Parser::Repetition& repetition = std::get<Parser::Repetition>(entry);
+            bool plain = true;
+            for (const Parser::ExpressionToken& token : repetition.count.rpn)
+                if (token.type != Type::Integer && token.type != Type::Operator)
+                    plain = false;
+
+            const Parser::DataDefinition& dataDefinition = std::get<Parser::DataDefinition>(section.entries[++i]);
+            if (!plain || dataDefinition.reserved) continue;
+
+            const Int128 count = Evaluate(repetition.count, 0, 0, &section.name).result;
+            const uint64_t unit = dataDefinition.size * dataDefinition.values.size();
+            if (count > 0 && unit != 0 && count <= static_cast<Int128>((std::numeric_limits<uint64_t>::max() - size) / unit))
+                size += unit * static_cast<uint64_t>(count);
         }
     }
+    return size;
 }
 
-void Encoder::Encoder::EncodeFinal(std::vector<Parser::Section>& parsedSections)
+size_t Encoder::Encoder::EncodeEntry(Parser::SectionEntry& entry, Section& sec)
 {
-    bytesWritten = 0;
-    for (Parser::Section& section : parsedSections)
+    size_t size;
+    if (std::holds_alternative<Parser::Instruction::Instruction>(entry))
     {
-        Section sec;
-        sec.name = section.name;
-        sec.isInitialized = true;
-        sec.align = section.align;
-        if (section.name.compare(".bss") == 0)
-        {
-            sec.isInitialized = false;
-        }
+        Parser::Instruction::Instruction& instruction = std::get<Parser::Instruction::Instruction>(entry);
 
-        currentSection = &section.name;
-        sectionOffset = 0;
+        // symbols that aren't known yet are left as zeros and patched in ApplyFixups
+        const bool resolvable = Resolvable(instruction);
+        const InstructionBuffer encoded = EncodeInstruction(instruction, !resolvable);
+        size = encoded.size();
 
-        for (size_t i = 0; i < section.entries.size(); i++)
+        if (!resolvable)
+            fixups.push_back({&entry, sections.size(), sec.buffer.size(), size, bytesWritten, sectionOffset, currentSection});
+
+        if (sec.isInitialized)
+            sec.buffer.insert(sec.buffer.end(), encoded.begin(), encoded.end());
+        else
+            sec.reservedSize += size;
+    }
+    else
+    {
+        const Parser::DataDefinition& dataDefinition = std::get<Parser::DataDefinition>(entry);
+
+        const bool resolvable = Resolvable(dataDefinition);
+
+        SectionBuffer& out = sec.isInitialized ? sec.buffer : scratch;
+        scratch.clear();
+        const size_t start = out.size();
+        EncodeData(dataDefinition, out, !resolvable);
+        size = out.size() - start;
+
+        if (!resolvable)
+            fixups.push_back({&entry, sections.size(), start, size, bytesWritten, sectionOffset, currentSection});
+
+        if (!sec.isInitialized)
+            sec.reservedSize += size;
+    }
+
+    sectionOffset += size;
+    bytesWritten += size;
+    return size;
+}
+
+// the first size bytes at data are copied until count copies fill the range, doubling each time
+static void replicate(uint8_t* data, size_t size, uint64_t count)
+{
+    const size_t total = size * count;
+    for (size_t filled = size; filled < total; filled *= 2)
+        std::memcpy(data + filled, data, std::min(filled, total - filled));
+}
+
+void Encoder::Encoder::RepeatEntry(Parser::SectionEntry& entry, Section& sec, uint64_t count, size_t lineNumber, size_t column)
+{
+    const size_t start = sec.buffer.size();
+    const size_t firstFixup = fixups.size();
+    const size_t firstRelocation = relocations.size();
+
+    const size_t size = EncodeEntry(entry, sec);
+    if (size == 0 || count == 1)
+        return;
+
+    if (count > std::numeric_limits<size_t>::max() / size)
+        throw Exception::SemanticError("Repetition too large", lineNumber, column);
+    const size_t extra = size * (count - 1);
+
+    if (sec.isInitialized)
+    {
+        sec.buffer.resize(start + size * count);
+        replicate(sec.buffer.data() + start, size, count);
+    }
+    else
+        sec.reservedSize += extra;
+
+    for (size_t f = firstFixup; f < fixups.size(); f++)
+        fixups[f].count = count;
+
+    // each copy needs its own relocations
+    const size_t relocationCount = relocations.size() - firstRelocation;
+    if (relocationCount != 0)
+    {
+        relocations.reserve(relocations.size() + relocationCount * (count - 1));
+        for (uint64_t n = 1; n < count; n++)
         {
-            Parser::SectionEntry& entry = section.entries[i];
-            
-            if (std::holds_alternative<Parser::Instruction::Instruction>(entry))
+            for (size_t r = 0; r < relocationCount; r++)
             {
-                Parser::Instruction::Instruction& instruction = std::get<Parser::Instruction::Instruction>(entry);
-                const std::vector<uint8_t> encoded = EncodeInstruction(instruction);
-                const size_t size = encoded.size();
-                
-                if (sec.isInitialized)
-                    sec.buffer.insert(sec.buffer.end(), encoded.begin(), encoded.end());
-                else
-                    sec.reservedSize += size;
-                
-                sectionOffset += size;
-                bytesWritten += size;
+                Relocation copy = relocations[firstRelocation + r];
+                copy.offsetInSection += n * size;
+                relocations.push_back(std::move(copy));
             }
-            else if (std::holds_alternative<Parser::DataDefinition>(entry))
-            {
-                const Parser::DataDefinition& dataDefinition = std::get<Parser::DataDefinition>(entry);
-                const std::vector<uint8_t> encoded = EncodeData(dataDefinition);
-                const size_t size = encoded.size();
+        }
+    }
 
-                if (sec.isInitialized)
-                    sec.buffer.insert(sec.buffer.end(), encoded.begin(), encoded.end());
-                else
-                    sec.reservedSize += size;
+    sectionOffset += extra;
+    bytesWritten += extra;
+}
 
-                sectionOffset += size;
-                bytesWritten += size;
-            }
-            else if (std::holds_alternative<Parser::Repetition>(entry))
-            {
-                const Parser::Repetition& repetition = std::get<Parser::Repetition>(entry);
-                const Evaluation countEval = Evaluate(repetition.count, bytesWritten, sectionOffset, currentSection);
-                const Int128& count128 = countEval.result;
-
-                if (count128 < 0)
-                    throw Exception::SemanticError("Repetition count can't be negative", repetition.lineNumber, repetition.column);
-                
-                if (count128 > std::numeric_limits<uint64_t>::max())
-                    throw Exception::InternalError("Repetition count to large for unsigned 64-bit integer", repetition.lineNumber, repetition.column);
-
-                const uint64_t count = static_cast<uint64_t>(count128);
-                // TODO
-            }
-            else if (std::holds_alternative<Parser::Alignment>(entry))
-            {
-                const Parser::Alignment& alignment = std::get<Parser::Alignment>(entry);
-                const Evaluation alignEval = Evaluate(alignment.align, bytesWritten, sectionOffset, currentSection);
-                const Int128& align = alignEval.result;
-                
-                if (align <= 0)
-                    throw Exception::SemanticError("Alignment cannot be zero or lower", alignment.lineNumber, alignment.column);
-                
-                const Int128 offset128 = static_cast<Int128>(sectionOffset);
-                const Int128 padding128 = (align - (offset128 % align)) % align;
-                if (padding128 > std::numeric_limits<size_t>::max())
-                    throw Exception::InternalError("Padding too large for size_t", alignment.lineNumber, alignment.column);
-
-                const size_t padding = static_cast<size_t>(padding128);
-                if (padding > 0)
-                {
-                    // TODO: really ugly, but works for now
-                    std::vector<uint8_t> paddingBytes = EncodePadding(padding);
+bool Encoder::Encoder::UsesPosition(const Parser::Immediate& immediate)
+{
+    for (const Parser::ExpressionToken& token : immediate.rpn)
+    {
+        if (token.type == Parser::ExpressionToken::Type::Position || token.type == Parser::ExpressionToken::Type::SectionPosition)
+            return true;
 
-                    if (sec.isInitialized)
-                        sec.buffer.insert(sec.buffer.end(), paddingBytes.begin(), paddingBytes.end());
-                    else
-                        sec.reservedSize += padding;
+        // constants can hide a '$' too
+        if (token.type == Parser::ExpressionToken::Type::String)
+        {
+            const Constant* c = findConstant(token.value);
+            if (c && c->hasPos == HasPos::TRUE)
+                return true;
+        }
+    }
+    return false;
+}
 
-                    sectionOffset += padding;
-                    bytesWritten += padding;
+bool Encoder::Encoder::UsesPosition(const Parser::SectionEntry& entry)
+{
+    if (std::holds_alternative<Parser::Instruction::Instruction>(entry))
+    {
+        for (const auto& operand : std::get<Parser::Instruction::Instruction>(entry).operands)
+            if (std::holds_alternative<Parser::Immediate>(operand) && UsesPosition(std::get<Parser::Immediate>(operand)))
+                return true;
+    }
+    else if (std::holds_alternative<Parser::DataDefinition>(entry))
+    {
+        for (const auto& value : std::get<Parser::DataDefinition>(entry).values)
+            if (UsesPosition(value))
+                return true;
+    }
+    return false;
+}
+
+void Encoder::Encoder::ApplyFixups()
+{
+    for (const RepetitionCheck& check : repetitionChecks)
+    {
+        const Int128 count = Evaluate(check.repetition->count, check.bytesWritten, check.sectionOffset, check.currentSection).result;
+        if (count != static_cast<Int128>(check.count))
+            throw Exception::SemanticError("Repetition count depends on code after it", check.repetition->lineNumber, check.repetition->column);
+    }
+    repetitionChecks.clear();
+
+    if (fixups.empty())
+        return;
+
+    for (const Fixup& fixup : fixups)
+    {
+        const size_t firstRelocation = relocations.size();
+        bytesWritten = fixup.bytesWritten;
+        sectionOffset = fixup.sectionOffset;
+        currentSection = fixup.currentSection;
+
+        scratch.clear();
+        size_t lineNumber, column;
+        if (std::holds_alternative<Parser::Instruction::Instruction>(*fixup.entry))
+        {
+            Parser::Instruction::Instruction& instruction = std::get<Parser::Instruction::Instruction>(*fixup.entry);
+            const InstructionBuffer encoded = EncodeInstruction(instruction);
+            scratch.insert(scratch.end(), encoded.begin(), encoded.end());
+            lineNumber = instruction.lineNumber;
+            column = instruction.column;
+        }
+        else
+        {
+            const Parser::DataDefinition& dataDefinition = std::get<Parser::DataDefinition>(*fixup.entry);
+            EncodeData(dataDefinition, scratch);
+            lineNumber = dataDefinition.lineNumber;
+            column = dataDefinition.column;
+        }
+
+        if (scratch.size() != fixup.size)
+            throw Exception::InternalError("Size changed while resolving symbols", lineNumber, column);
+
+        Section& sec = sections[fixup.section];
+        if (sec.isInitialized)
+        {
+            std::copy(scratch.begin(), scratch.end(), sec.buffer.begin() + fixup.offset);
+            replicate(sec.buffer.data() + fixup.offset, fixup.size, fixup.count);
+        }
+
+        // repeated entries, relocations of the first copy were just added
+        if (fixup.count > 1)
+        {
+            const size_t added = relocations.size() - firstRelocation;
+            for (uint64_t n = 1; n < fixup.count; n++)
+            {
+                for (size_t r = 0; r < added; r++)
+                {
+                    Relocation copy = relocations[firstRelocation + r];
+                    copy.offsetInSection += n * fixup.size;
+                    relocations.push_back(std::move(copy));
                 }
-            }  
+            }
         }
+    }
+    fixups.clear();
+}
+
+void Encoder::Encoder::IndexRelocations()
+{
+    std::unordered_map<std::string_view, size_t> sectionIndices;
+    for (size_t i = 0; i < sections.size(); i++)
+        sectionIndices.emplace(sections[i].name, i);
 
-        sections.push_back(sec);
+    for (Relocation& relocation : relocations)
+    {
+        auto it = sectionIndices.find(relocation.section);
+        if (it == sectionIndices.end())
+            throw Exception::InternalError("Section '" + relocation.section + "' of a relocation wasn't found", -1, -1);
+        relocation.sectionIndex = it->second;
+
+        if (!relocation.isExtern)
+        {
+            it = sectionIndices.find(relocation.usedSection);
+            if (it != sectionIndices.end())
+                relocation.usedSectionIndex = it->second;
+        }
     }
+
+    // patched entries add their relocations at the end, put them back in section and offset order
+    auto inOrder = [](const Relocation& a, const Relocation& b)
+    {
+        if (a.sectionIndex != b.sectionIndex) return a.sectionIndex < b.sectionIndex;
+        return a.offsetInSection < b.offsetInSection;
+    };
+    if (!std::is_sorted(relocations.begin(), relocations.end(), inOrder))
+        std::stable_sort(relocations.begin(), relocations.end(), inOrder);
 }
 
 void Encoder::Encoder::Print() const
@@ -282,9 +535,14 @@ void Encoder::Encoder::Print() const
         std::cout << "  Size: " << section.size() << std::endl;
     }
 
-    for (const auto& constant : constants)
+    if (relaxationStats.candidates != 0)
+    {
+        std::cout << "Relaxation: " << relaxationStats.shrunk << " of " << relaxationStats.candidates
+                  << " instructions shrunk in " << relaxationStats.passes << " passes" << std::endl;
+    }
+
+    for (const Constant& c : constants)
     {
-        const Constant& c = constant.second;
         if (c.resolved)
             std::cout << "Resolved constant ";
         else
@@ -313,9 +571,8 @@ void Encoder::Encoder::Print() const
         std::cout << std::endl;
     }
 
-    for (const auto& label : labels)
+    for (const Label& l : labels)
     {
-        const Label& l = label.second;
         if (l.resolved)
             std::cout << "Resolved ";
         else
@@ -345,6 +602,7 @@ void Encoder::Encoder::Print() const
         switch (reloc.type)
         {
             case RelocationType::Absolute: std::cout << "Absolute"; break;
+            case RelocationType::Relative: std::cout << "Relative"; break;
         }
         std::cout << std::endl << "  Addend: " << reloc.addend << std::endl;
     }
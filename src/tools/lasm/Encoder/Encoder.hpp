@@ -4,13 +4,55 @@
 #include <vector>
 #include <IntTypesC.h>
 #include <unordered_set>
+#include <initializer_list>
+#include <cstring>
+#include <limits>
 #include "../Context.hpp"
 #include "../Parser/Parser.hpp"
+#include "SymbolTable.hpp"
+#include "LinearForm.hpp"
 
 namespace Encoder
 {
     using SectionBuffer = std::vector<uint8_t>;
 
+    // bytes of a single instruction, kept inline so encoding doesn't allocate
+    class InstructionBuffer
+    {
+    public:
+        static constexpr size_t capacity = 15;    // longest valid x86 instruction
+
+        InstructionBuffer() = default;
+        InstructionBuffer(std::initializer_list<uint8_t> init)
+        {
+            append(init.begin(), init.size());
+        }
+
+        void push_back(uint8_t byte)
+        {
+            if (count >= capacity)
+                throw Exception::InternalError("Instruction longer than " + std::to_string(capacity) + " bytes", -1, -1);
+            bytes[count++] = byte;
+        }
+
+        void append(const uint8_t* data, size_t size)
+        {
+            if (count + size > capacity)
+                throw Exception::InternalError("Instruction longer than " + std::to_string(capacity) + " bytes", -1, -1);
+            std::memcpy(bytes + count, data, size);
+            count += size;
+        }
+
+        const uint8_t* data() const noexcept { return bytes; }
+        size_t size() const noexcept { return count; }
+        const uint8_t* begin() const noexcept { return bytes; }
+        const uint8_t* end() const noexcept { return bytes + count; }
+
+    private:
+        uint8_t bytes[capacity];
+        size_t count = 0;
+    };
+
     struct Section
     {
         std::string name;
@@ -51,6 +93,7 @@ namespace Encoder
 
         int64_t off;
         std::string usedSection;
+        bool usedExtern = false;
 
         HasPos hasPos;
         bool useOffset = false;
@@ -62,11 +105,20 @@ namespace Encoder
         bool resolved;
         bool prePass = false;
         bool relocationPossible = false;
+
+        // indices of the constants this one uses, a range of Encoder::constantDependencies
+        size_t firstDependency = 0;
+        size_t dependencyCount = 0;
+        bool dependsOnLabel = false;
+
+        size_t lineNumber;
+        size_t column;
     };
 
     enum class RelocationType
     {
-        Absolute
+        Absolute,
+        Relative    // to the address of the relocated field
     };
 
     enum class RelocationSize
@@ -90,6 +142,11 @@ namespace Encoder
 
         bool addendInCode = false;
         bool isExtern = false;
+
+        // indices into the sections of the encoder, set once encoding is done
+        static constexpr size_t noSection = std::numeric_limits<size_t>::max();
+        size_t sectionIndex = noSection;
+        size_t usedSectionIndex = noSection;    // stays noSection for extern labels
     };
 
 
@@ -100,6 +157,8 @@ namespace Encoder
         bool useOffset;
         bool relocationPossible;
         bool isExtern;
+        // target - $ instead of target, see makeRelocation
+        bool pcRelative;
 
         std::string usedSection;
     };
@@ -110,37 +169,63 @@ namespace Encoder
     {
     public:
         Encoder(const Context& _context, Architecture _arch, BitMode _bits, const Parser::Parser* _parser);
+        Encoder(const Encoder&) = delete;
         virtual ~Encoder() = default;
 
         void Encode();
         void Optimize();
         void Print() const;
 
-        using Symbol = std::variant<Label*, Constant*>;
         const std::vector<Section>& getSections() const { return sections; };
         const std::vector<Symbol>& getSymbols() const { return symbols; };
+        const std::vector<Label>& getLabels() const { return labels; }
+        const std::vector<Constant>& getConstants() const { return constants; }
         const std::vector<Relocation>& getRelocations() const { return relocations; }
         
     protected:
         void EncodeFinal(std::vector<Parser::Section>& parsedSections);
-        void GetOffsets(std::vector<Parser::Section>& parsedSections);
+        void EncodeSection(Parser::Section& section, uint64_t sizeHint);
+        // returns false if the sections have to be encoded one after another
+        bool EncodeSectionsInParallel(std::vector<Parser::Section>& parsedSections);
+        // big enough and enough threads, OptimizeOffsets has to lay out the sections then
+        bool ShouldEncodeInParallel(const std::vector<Parser::Section>& parsedSections) const;
+        void ApplyFixups();
+        // resolves the section names of the relocations to indices and sorts them by section and offset
+        void IndexRelocations();
+        // instructions and data, returns the size that was added to the section
+        size_t EncodeEntry(Parser::SectionEntry& entry, Section& sec);
+        void RepeatEntry(Parser::SectionEntry& entry, Section& sec, uint64_t count, size_t lineNumber, size_t column);
+        bool UsesPosition(const Parser::Immediate& immediate);
+        bool UsesPosition(const Parser::SectionEntry& entry);
         void ResolveConstantsPrePass(const std::vector<Parser::Section>& parsedSections);
+        // lower bound for the encoded size, without encoding anything
+        uint64_t MinimumSize(const Parser::Section& section);
+
+        // worker for a single section, it shares the symbols of its owner and only reads them
+        explicit Encoder(Encoder* owner);
 
         virtual bool OptimizeOffsets(std::vector<Parser::Section>& parsedSections) = 0;
+        virtual Encoder* CreateWorker() = 0;
 
-        virtual std::vector<uint8_t> EncodeInstruction(Parser::Instruction::Instruction& instruction, bool ignoreUnresolved = false, bool optimize = false) = 0;
-        virtual uint64_t GetSize(Parser::Instruction::Instruction& instruction) = 0;
-        virtual std::vector<uint8_t> EncodePadding(size_t length) = 0;
-        std::vector<uint8_t> EncodeData(const Parser::DataDefinition& dataDefinition);
-        uint64_t GetSize(const Parser::DataDefinition& dataDefinition);
+        // with ignoreUnresolved, unknown symbols are encoded as zeros without changing the size
+        virtual InstructionBuffer EncodeInstruction(Parser::Instruction::Instruction& instruction, bool ignoreUnresolved = false, bool optimize = false) = 0;
+        // data and padding are appended to out, padding is only used in code and encoded for the mode at the align
+        virtual void EncodePadding(SectionBuffer& out, size_t length, BitMode mode) = 0;
+        void EncodeData(const Parser::DataDefinition& dataDefinition, SectionBuffer& out, bool ignoreUnresolved = false);
 
         Evaluation Evaluate(const Parser::Immediate& immediate, uint64_t bytesWritten, uint64_t sectionOffset, const std::string* curSection);
+        LinearForm EvaluateLinear(const Parser::Immediate& immediate, uint64_t bytesWritten, uint64_t sectionOffset, const std::string* curSection);
+        static Relocation makeRelocation(const Evaluation& evaluation, uint64_t offsetInSection, const std::string& section);
+
+        Label* findLabel(uint64_t name);
+        Constant* findConstant(uint64_t name);
 
         void resolveConstants(bool withPos);
         bool Resolvable(const Parser::Immediate& immediate);
-        std::vector<std::string> getDependencies(const Parser::Immediate& immediate);
-        bool resolveConstantWithoutPos(Constant& c, std::unordered_set<std::string>& visited);
-        bool resolveConstantWithPos(Constant& c, std::unordered_set<std::string>& visited);
+        bool Resolvable(const Parser::Instruction::Instruction& instruction);
+        bool Resolvable(const Parser::DataDefinition& dataDefinition);
+        void buildConstantGraph();
+        void resolveConstant(Constant& c, bool withPos);
 
         Context context;
         Architecture arch;
@@ -151,11 +236,80 @@ namespace Encoder
         std::vector<Section> sections;
         std::vector<Relocation> relocations;
 
-        std::unordered_map<std::string, uint64_t> sectionStarts;
-        std::unordered_map<std::string, Label> labels;
-        std::unordered_map<std::string, Constant> constants;
-
-        std::vector<Symbol> symbols;
+        // entry that used a symbol before it was known, encoded again once everything is resolved
+        struct Fixup
+        {
+            Parser::SectionEntry* entry;
+            size_t section;
+            size_t offset;
+            size_t size;
+
+            size_t bytesWritten;
+            size_t sectionOffset;
+            const std::string* currentSection;
+
+            // copies of a repeated entry, back to back
+            uint64_t count = 1;
+        };
+        std::vector<Fixup> fixups;
+
+        // counts that use symbols, they have to come out the same once everything is placed
+        struct RepetitionCheck
+        {
+            const Parser::Repetition* repetition;
+            uint64_t count;
+
+            size_t bytesWritten;
+            size_t sectionOffset;
+            const std::string* currentSection;
+        };
+        std::vector<RepetitionCheck> repetitionChecks;
+
+        // filled by OptimizeOffsets
+        struct RelaxationStats
+        {
+            size_t candidates = 0;  // instructions with more than one encoding
+            size_t shrunk = 0;      // encoded shorter than the longest form
+            size_t passes = 0;
+        };
+        RelaxationStats relaxationStats;
+        // exact size of every parsed section, left empty when OptimizeOffsets had nothing to lay out
+        std::vector<uint64_t> sectionSizes;
+        // smaller inputs aren't worth the threads and laying out the sections up front
+        static constexpr size_t minParallelEntries = 4096;
+
+        // target for data that isn't kept, e.g. in .bss, reused to avoid allocations
+        SectionBuffer scratch;
+
+        struct SymbolStorage
+        {
+            std::unordered_map<std::string, uint64_t> sectionStarts;
+            SymbolTable symbolTable;
+            std::vector<Label> labels;
+            std::vector<Constant> constants;
+            std::vector<uint32_t> constantOrder;
+            std::vector<uint32_t> constantDependencies;
+            std::vector<Symbol> symbols;
+        };
+        // left empty in workers, their references point to the storage of the owner
+        SymbolStorage ownSymbols;
+
+        std::unordered_map<std::string, uint64_t>& sectionStarts = ownSymbols.sectionStarts;
+        // labels and constants in order of definition, symbolTable maps names to them
+        SymbolTable& symbolTable = ownSymbols.symbolTable;
+        std::vector<Label>& labels = ownSymbols.labels;
+        std::vector<Constant>& constants = ownSymbols.constants;
+        // constants ordered so that everything one uses comes before it
+        std::vector<uint32_t>& constantOrder = ownSymbols.constantOrder;
+        std::vector<uint32_t>& constantDependencies = ownSymbols.constantDependencies;
+
+        std::vector<Symbol>& symbols = ownSymbols.symbols;
+
+        // set in workers: labels and constants aren't written, only checked against the layout
+        bool worker = false;
+        bool matchesLayout = true;
+        // labels that became used externs in a worker, merged by the owner
+        std::vector<uint32_t> externUses;
 
         size_t bytesWritten = 0;
         size_t sectionOffset = 0;
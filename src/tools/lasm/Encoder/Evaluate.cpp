@@ -1,74 +1,173 @@
 #include "Encoder.hpp"
 
-#include "ShuntingYard.hpp"
-
-Encoder::Evaluation Encoder::Encoder::Evaluate(const Parser::Immediate& immediate, uint64_t bytesWritten, uint64_t sectionOffset, const std::string* curSection)
+Encoder::LinearForm Encoder::Encoder::EvaluateLinear(const Parser::Immediate& immediate, uint64_t bytesWritten, uint64_t sectionOffset, const std::string* curSection)
 {
-    // substitute position with two different values:
-    // if both are equal:                               position doesn't matter
-    // if both are equal when subtracting position:     can be written using offset + position (relocation)
-    // else:                                            not even relocation is possible
-    ShuntingYard::PreparedTokens tokens = ShuntingYard::prepareTokens(immediate.operands, labels, constants, bytesWritten, sectionOffset, curSection);
+    using Type = Parser::ExpressionToken::Type;
+    using Operator = Parser::ExpressionToken::Operator;
+
+    const Int128 currentStart = static_cast<Int128>(bytesWritten) - static_cast<Int128>(sectionOffset);
 
-    if (tokens.relocationPossible)
+    // start of a section in the output, only needed for expressions that can't be relocated
+    auto startOf = [&](const std::string& section) -> Int128
     {
-        uint64_t off1;
-        if (tokens.isExtern) off1 = 348234582348;
-        else
-        {
-            auto it = sectionStarts.find(tokens.usedSection);
-            if (it == sectionStarts.end()) throw Exception::InternalError("Couldn't find start of used section", -1, -1);
-            off1 = it->second;
-        }
-        uint64_t off2 = off1 + 0x12345678;
+        if (section == *curSection) return currentStart;
+        auto it = sectionStarts.find(section);
+        return it != sectionStarts.end() ? static_cast<Int128>(it->second) : currentStart;
+    };
 
-        Int128 res1 = ShuntingYard::evaluate(tokens.tokens, off1);
-        Int128 res2 = ShuntingYard::evaluate(tokens.tokens, off2);
+    std::vector<LinearForm> stack;
+    stack.reserve(immediate.rpn.size());
 
-        Evaluation evaluation;
-        evaluation.result = res1;
-        evaluation.usedSection = tokens.usedSection;
-        evaluation.isExtern = tokens.isExtern;
-        if (res1 == res2)
-        {
-            evaluation.useOffset = false;
-            evaluation.relocationPossible = true;
-            evaluation.offset = 0;
-        }
-        else if ((res1 - off1) == (res2 - off2))
+    for (const Parser::ExpressionToken& token : immediate.rpn)
+    {
+        if (token.type == Type::Operator)
         {
-            evaluation.useOffset = true;
-            evaluation.relocationPossible = true;
-            evaluation.offset = res1 - off1;
+            if (stack.size() < 2)
+                throw Exception::InternalError("Invalid expression: not enough operands", -1, -1);
+
+            const LinearForm rhs = stack.back(); stack.pop_back();
+            LinearForm& lhs = stack.back();
+
+            switch (token.op)
+            {
+                case Operator::Add: lhs.add(rhs, false); break;
+                case Operator::Sub: lhs.add(rhs, true); break;
+                case Operator::Mul: lhs.multiply(rhs); break;
+                case Operator::Div: lhs.divide(rhs); break;
+                case Operator::Mod: lhs.modulo(rhs); break;
+            }
+            continue;
         }
+
+        if (token.type == Type::Integer)
+            stack.push_back(LinearForm::number(static_cast<Int128>(token.value)));
+        else if (token.type == Type::Position)
+            stack.push_back(LinearForm::position(*curSection, false, sectionOffset, currentStart));
+        else if (token.type == Type::SectionPosition)
+            stack.push_back(LinearForm::position(*curSection, false, 0, currentStart));
         else
         {
-            evaluation.useOffset = false;
-            evaluation.relocationPossible = false;
-            evaluation.offset = 0;
+            const Symbol symbol = symbolTable.find(token.value);
+            if (symbol.kind == SymbolKind::Label)
+            {
+                const Label& label = labels[symbol.index];
+                if (label.isExtern)
+                    stack.push_back(LinearForm::position(label.name, true, 0, 0));
+                else
+                    stack.push_back(LinearForm::position(label.section, false, label.offset, startOf(label.section)));
+            }
+            else if (symbol.kind == SymbolKind::Constant)
+            {
+                const Constant& c = constants[symbol.index];
+                if (!c.resolved)
+                    throw Exception::InternalError("Unresolved constants '" + c.name + "' used in expression", -1, -1);
+
+                if (c.useOffset)
+                    stack.push_back(LinearForm::position(c.usedSection, c.usedExtern, c.off, c.usedExtern ? 0 : startOf(c.usedSection)));
+                else
+                {
+                    stack.push_back(LinearForm::number(c.value));
+                    stack.back().linear = c.relocationPossible;
+                }
+            }
+            else throw Exception::InternalError("Unknown string '" + context.stringPool->lookup(token.value) + "'", -1, -1);
         }
 
-        if (evaluation.relocationPossible && evaluation.isExtern)
+        if (token.negative)
+            stack.back().negate();
+    }
+
+    if (stack.size() != 1)
+        throw Exception::SyntaxError("Invalid expression", -1, -1);
+
+    return stack.back();
+}
+
+Encoder::Evaluation Encoder::Encoder::Evaluate(const Parser::Immediate& immediate, uint64_t bytesWritten, uint64_t sectionOffset, const std::string* curSection)
+{
+    const LinearForm form = EvaluateLinear(immediate, bytesWritten, sectionOffset, curSection);
+
+    Evaluation evaluation;
+    evaluation.result = form.flat;
+    evaluation.offset = 0;
+    evaluation.useOffset = false;
+    evaluation.relocationPossible = false;
+    evaluation.pcRelative = false;
+    evaluation.isExtern = false;
+    evaluation.usedSection = *curSection;
+
+    if (!form.linear)
+        return evaluation;
+
+    const LinearForm::Term* target = nullptr;
+    if (form.termCount == 0)
+    {
+        // positions cancel out, e.g. the distance between two labels
+        evaluation.result = form.constant;
+        evaluation.relocationPossible = true;
+        return evaluation;
+    }
+    else if (form.termCount == 1 && form.terms[0].coefficient == 1)
+        target = &form.terms[0];
+    else if (form.termCount == 2)
+    {
+        // target - $, relative to where the value ends up
+        for (size_t i = 0; i < 2; i++)
         {
-            if (auto it = labels.find(evaluation.usedSection); it != labels.end())
+            const LinearForm::Term& self = form.terms[1 - i];
+            if (form.terms[i].coefficient == 1 && self.coefficient == -1 && !self.isExtern && self.base == *curSection)
             {
-                it->second.externUsed = true;
+                target = &form.terms[i];
+                evaluation.pcRelative = true;
             }
         }
+    }
 
+    if (!target)
         return evaluation;
+
+    evaluation.useOffset = true;
+    evaluation.relocationPossible = true;
+    evaluation.offset = static_cast<int64_t>(form.constant);
+    evaluation.isExtern = target->isExtern;
+    evaluation.usedSection = std::string(target->base);
+
+    if (evaluation.isExtern)
+    {
+        uint64_t name;
+        if (context.stringPool->find(evaluation.usedSection, name))
+        {
+            const Symbol symbol = symbolTable.find(name);
+            if (symbol.kind == SymbolKind::Label)
+            {
+                if (worker)
+                    externUses.push_back(symbol.index);
+                else
+                    labels[symbol.index].externUsed = true;
+            }
+        }
     }
-    else
+
+    return evaluation;
+}
+
+// the size is left to the caller
+Encoder::Relocation Encoder::Encoder::makeRelocation(const Evaluation& evaluation, uint64_t offsetInSection, const std::string& section)
+{
+    Relocation reloc;
+    reloc.offsetInSection = offsetInSection;
+    reloc.addend = evaluation.offset;
+    reloc.addendInCode = true;
+    reloc.section = section;
+    reloc.usedSection = evaluation.usedSection;
+    reloc.type = RelocationType::Absolute;
+    reloc.isExtern = evaluation.isExtern;
+
+    // the linker subtracts the address of the field, the expression subtracted the start of the section
+    if (evaluation.pcRelative)
     {
-        Int128 result = ShuntingYard::evaluate(tokens.tokens, bytesWritten - sectionOffset);
-
-        Evaluation evaluation;
-        evaluation.result = result;
-        evaluation.usedSection = tokens.usedSection;
-        evaluation.useOffset = false;
-        evaluation.relocationPossible = false;
-        evaluation.isExtern = false;
-        evaluation.offset = 0;
-        return evaluation;
+        reloc.type = RelocationType::Relative;
+        reloc.addend += static_cast<int64_t>(offsetInSection);
     }
-}
\ No newline at end of file
+    return reloc;
+}
@@ -0,0 +1,136 @@
+#include "LinearForm.hpp"
+
+#include <Exception.hpp>
+
+Encoder::LinearForm Encoder::LinearForm::number(Int128 value)
+{
+    LinearForm form;
+    form.constant = value;
+    form.flat = value;
+    return form;
+}
+
+Encoder::LinearForm Encoder::LinearForm::position(std::string_view base, bool isExtern, Int128 offset, Int128 baseStart)
+{
+    LinearForm form;
+    form.constant = offset;
+    form.flat = baseStart + offset;
+    form.terms[0] = { base, isExtern, 1 };
+    form.termCount = 1;
+    return form;
+}
+
+void Encoder::LinearForm::addTerm(const Term& term, Int128 factor)
+{
+    const Int128 coefficient = term.coefficient * factor;
+
+    for (uint8_t i = 0; i < termCount; i++)
+    {
+        Term& existing = terms[i];
+        if (existing.isExtern != term.isExtern || existing.base != term.base) continue;
+
+        existing.coefficient += coefficient;
+        if (existing.coefficient == 0)
+            existing = terms[--termCount];
+        return;
+    }
+
+    if (termCount == maxTerms)
+    {
+        linear = false;
+        return;
+    }
+    terms[termCount++] = { term.base, term.isExtern, coefficient };
+}
+
+void Encoder::LinearForm::scale(Int128 factor)
+{
+    constant *= factor;
+    if (factor == 0)
+    {
+        termCount = 0;
+        return;
+    }
+    for (uint8_t i = 0; i < termCount; i++)
+        terms[i].coefficient *= factor;
+}
+
+void Encoder::LinearForm::negate()
+{
+    constant = -constant;
+    flat = -flat;
+    for (uint8_t i = 0; i < termCount; i++)
+        terms[i].coefficient = -terms[i].coefficient;
+}
+
+void Encoder::LinearForm::add(const LinearForm& rhs, bool subtract)
+{
+    const Int128 factor = subtract ? -1 : 1;
+
+    constant += rhs.constant * factor;
+    flat += rhs.flat * factor;
+    linear = linear && rhs.linear;
+
+    for (uint8_t i = 0; i < rhs.termCount; i++)
+        addTerm(rhs.terms[i], factor);
+}
+
+void Encoder::LinearForm::multiply(const LinearForm& rhs)
+{
+    flat *= rhs.flat;
+    linear = linear && rhs.linear;
+
+    if (rhs.termCount == 0)
+        scale(rhs.constant);
+    else if (termCount == 0)
+    {
+        const Int128 factor = constant;
+        const Int128 product = flat;
+        const bool bothLinear = linear;
+        *this = rhs;
+        scale(factor);
+        flat = product;
+        linear = bothLinear;
+    }
+    else
+        linear = false;
+}
+
+void Encoder::LinearForm::divide(const LinearForm& rhs)
+{
+    if (rhs.flat == 0 || (rhs.termCount == 0 && rhs.constant == 0))
+        throw Exception::SemanticError("Division by zero", -1, -1);
+
+    flat /= rhs.flat;
+    linear = linear && rhs.linear && rhs.termCount == 0;
+    if (!linear) return;
+
+    // positions can only be divided when nothing gets truncated
+    const Int128 divisor = rhs.constant;
+    if (termCount != 0)
+    {
+        bool exact = constant % divisor == 0;
+        for (uint8_t i = 0; i < termCount && exact; i++)
+            exact = terms[i].coefficient % divisor == 0;
+
+        if (!exact)
+        {
+            linear = false;
+            return;
+        }
+        for (uint8_t i = 0; i < termCount; i++)
+            terms[i].coefficient /= divisor;
+    }
+    constant /= divisor;
+}
+
+void Encoder::LinearForm::modulo(const LinearForm& rhs)
+{
+    if (rhs.flat == 0 || (rhs.termCount == 0 && rhs.constant == 0))
+        throw Exception::SemanticError("Modulo by zero", -1, -1);
+
+    flat %= rhs.flat;
+    linear = linear && rhs.linear && rhs.termCount == 0 && termCount == 0;
+    if (linear)
+        constant %= rhs.constant;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <IntTypesC.h>
+#include <string_view>
+#include <inttypes.h>
+#include <stddef.h>
+
+namespace Encoder
+{
+    // constant + sum of coefficient * base, a base is the start of a section or an extern label
+    struct LinearForm
+    {
+        struct Term
+        {
+            std::string_view base;
+            bool isExtern;
+            Int128 coefficient;
+        };
+
+        // more distinct bases than this can't be relocated anyway
+        static constexpr size_t maxTerms = 4;
+
+        Int128 constant = 0;
+        // value with every base at its start in the output, kept for expressions that aren't linear
+        Int128 flat = 0;
+
+        Term terms[maxTerms];
+        uint8_t termCount = 0;
+        // false once positions were multiplied, divided or mixed with a constant that can't be relocated
+        bool linear = true;
+
+        static LinearForm number(Int128 value);
+        static LinearForm position(std::string_view base, bool isExtern, Int128 offset, Int128 baseStart);
+
+        void negate();
+        void add(const LinearForm& rhs, bool subtract);
+        void multiply(const LinearForm& rhs);
+        void divide(const LinearForm& rhs);
+        void modulo(const LinearForm& rhs);
+
+    private:
+        void addTerm(const Term& term, Int128 factor);
+        void scale(Int128 factor);
+    };
+}
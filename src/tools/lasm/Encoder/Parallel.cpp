@@ -0,0 +1,93 @@
+#include "Encoder.hpp"
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <exception>
+#include <algorithm>
+
+static size_t workerCountFor(size_t sectionCount)
+{
+    return std::min<size_t>(sectionCount, std::max(1u, std::thread::hardware_concurrency()));
+}
+
+bool Encoder::Encoder::ShouldEncodeInParallel(const std::vector<Parser::Section>& parsedSections) const
+{
+    if (parsedSections.size() < 2 || workerCountFor(parsedSections.size()) <= 1)
+        return false;
+
+    size_t entryCount = 0;
+    for (const Parser::Section& section : parsedSections)
+        entryCount += section.entries.size();
+    return entryCount >= minParallelEntries;
+}
+
+// Every section is encoded by its own worker. That only matches encoding them one after another
+// if OptimizeOffsets already placed every label: then no section depends on what an earlier one
+// writes, and the workers just have to agree with the layout.
+bool Encoder::Encoder::EncodeSectionsInParallel(std::vector<Parser::Section>& parsedSections)
+{
+    if (sectionSizes.size() != parsedSections.size() || !ShouldEncodeInParallel(parsedSections))
+        return false;
+
+    const size_t workerCount = workerCountFor(parsedSections.size());
+    std::vector<std::unique_ptr<Encoder>> sectionWorkers(parsedSections.size());
+    std::vector<std::exception_ptr> errors(parsedSections.size());
+
+    auto encodeSection = [&](size_t s)
+    {
+        try
+        {
+            sectionWorkers[s].reset(CreateWorker());
+            sectionWorkers[s]->bytesWritten = sectionStarts.at(parsedSections[s].name);
+            sectionWorkers[s]->EncodeSection(parsedSections[s], sectionSizes[s]);
+        }
+        catch (...)
+        {
+            errors[s] = std::current_exception();
+        }
+    };
+
+    std::atomic<size_t> next = 0;
+    std::vector<std::thread> threads;
+    for (size_t w = 0; w < workerCount; w++)
+    {
+        threads.emplace_back([&]()
+        {
+            for (size_t s = next++; s < parsedSections.size(); s = next++)
+                encodeSection(s);
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    // errors are reported by the serial path, in the order it would find them
+    for (size_t s = 0; s < parsedSections.size(); s++)
+    {
+        if (errors[s] || !sectionWorkers[s]->matchesLayout
+         || sectionWorkers[s]->sections.size() != 1 || sectionWorkers[s]->sections[0].size() != sectionSizes[s])
+            return false;
+    }
+
+    // merged in section order, the same order the serial path produces
+    for (size_t s = 0; s < parsedSections.size(); s++)
+    {
+        Encoder& sectionWorker = *sectionWorkers[s];
+
+        for (Fixup fixup : sectionWorker.fixups)
+        {
+            fixup.section = sections.size();
+            fixups.push_back(fixup);
+        }
+        repetitionChecks.insert(repetitionChecks.end(), sectionWorker.repetitionChecks.begin(), sectionWorker.repetitionChecks.end());
+        relocations.insert(relocations.end(), std::make_move_iterator(sectionWorker.relocations.begin()), std::make_move_iterator(sectionWorker.relocations.end()));
+
+        for (uint32_t label : sectionWorker.externUses)
+            labels[label].externUsed = true;
+
+        sections.push_back(std::move(sectionWorker.sections[0]));
+        sectionWorkers[s].reset();
+    }
+
+    bytesWritten = sectionStarts[parsedSections.back().name] + sections.back().size();
+    return true;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <vector>
+#include <inttypes.h>
+#include <stddef.h>
+
+namespace Encoder
+{
+    enum class SymbolKind : uint8_t
+    {
+        None,
+        Label,
+        Constant
+    };
+
+    // index into Encoder::labels or Encoder::constants, depending on kind
+    struct Symbol
+    {
+        SymbolKind kind = SymbolKind::None;
+        uint32_t index = 0;
+    };
+
+    // Open addressing with linear probing, keyed by StringPool ids.
+    // Symbols are never removed, so there are no tombstones.
+    class SymbolTable
+    {
+    public:
+        Symbol find(uint64_t name) const
+        {
+            if (slots.empty()) return {};
+
+            for (size_t i = hash(name) & mask; ; i = (i + 1) & mask)
+            {
+                const Slot& slot = slots[i];
+                if (slot.symbol.kind == SymbolKind::None) return {};
+                if (slot.name == name) return slot.symbol;
+            }
+        }
+
+        // returns false if the name is already taken
+        bool insert(uint64_t name, Symbol symbol)
+        {
+            if ((count + 1) * 4 > slots.size() * 3)
+                rehash(slots.empty() ? 64 : slots.size() * 2);
+
+            for (size_t i = hash(name) & mask; ; i = (i + 1) & mask)
+            {
+                Slot& slot = slots[i];
+                if (slot.symbol.kind == SymbolKind::None)
+                {
+                    slot.name = name;
+                    slot.symbol = symbol;
+                    count++;
+                    return true;
+                }
+                if (slot.name == name) return false;
+            }
+        }
+
+        void reserve(size_t symbols)
+        {
+            size_t capacity = 64;
+            while (capacity * 3 < symbols * 4) capacity *= 2;
+            if (capacity > slots.size())
+                rehash(capacity);
+        }
+
+        size_t size() const { return count; }
+
+    private:
+        struct Slot
+        {
+            uint64_t name = 0;
+            Symbol symbol;
+        };
+
+        // ids are handed out sequentially, spread them over the whole table
+        static size_t hash(uint64_t name)
+        {
+            uint64_t h = name * 0x9E3779B97F4A7C15ULL;
+            return static_cast<size_t>(h ^ (h >> 32));
+        }
+
+        void rehash(size_t capacity)
+        {
+            std::vector<Slot> old;
+            old.swap(slots);
+            slots.resize(capacity);
+            mask = capacity - 1;
+            count = 0;
+
+            for (const Slot& slot : old)
+                if (slot.symbol.kind != SymbolKind::None)
+                    insert(slot.name, slot.symbol);
+        }
+
+        std::vector<Slot> slots;
+        size_t mask = 0;
+        size_t count = 0;
+    };
+}
@@ -6,11 +6,22 @@ x86::Encoder::Encoder(const Context& _context, Architecture _arch, BitMode _bits
     
 }
 
-std::vector<uint8_t> x86::Encoder::EncodeInstruction(Parser::Instruction::Instruction& instruction, bool ignoreUnresolved, bool optimize)
+x86::Encoder::Encoder(Encoder* owner)
+    : ::Encoder::Encoder(owner), movImmForms(owner->movImmForms)
+{
+
+}
+
+::Encoder::Encoder* x86::Encoder::CreateWorker()
+{
+    return new Encoder(this);
+}
+
+::Encoder::InstructionBuffer x86::Encoder::EncodeInstruction(Parser::Instruction::Instruction& instruction, bool ignoreUnresolved, bool optimize)
 {
     instrUse16BitPrefix = false;
     
-    std::vector<uint8_t> instr;
+    ::Encoder::InstructionBuffer instr;
     switch (instruction.mnemonic)
     {
         // CONTROL
@@ -52,29 +63,44 @@ std::vector<uint8_t> x86::Encoder::EncodeInstruction(Parser::Instruction::Instru
         default: throw Exception::InternalError("Unknown instruction", instruction.lineNumber, instruction.column);
     }
 
-    std::vector<uint8_t> buf;
-
-    if (instrUse16BitPrefix) buf.push_back(0x66);
+    if (!instrUse16BitPrefix) return instr;
 
-    buf.insert(buf.end(), instr.begin(), instr.end());
+    ::Encoder::InstructionBuffer buf;
+    buf.push_back(0x66);
+    buf.append(instr.data(), instr.size());
     return buf;
 }
 
-bool x86::Encoder::OptimizeOffsets(std::vector<Parser::Section>& parsedSections)
-{
-    bool changed = true;
-    // TODO
-    return true;
-}
+// recommended multi-byte NOPs, the entry at index n is n bytes long
+static constexpr uint8_t multiByteNops[10][9] = {
+    {},
+    {0x90},
+    {0x66, 0x90},
+    {0x0F, 0x1F, 0x00},
+    {0x0F, 0x1F, 0x40, 0x00},
+    {0x0F, 0x1F, 0x44, 0x00, 0x00},
+    {0x66, 0x0F, 0x1F, 0x44, 0x00, 0x00},
+    {0x0F, 0x1F, 0x80, 0x00, 0x00, 0x00, 0x00},
+    {0x0F, 0x1F, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00},
+    {0x66, 0x0F, 0x1F, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00}
+};
 
-uint64_t x86::Encoder::GetSize(Parser::Instruction::Instruction& instruction)
+void x86::Encoder::EncodePadding(::Encoder::SectionBuffer& out, size_t length, BitMode mode)
 {
-    const std::vector<uint8_t> instr = EncodeInstruction(instruction, true, false);
-    return static_cast<uint64_t>(instr.size());
-}
+    // 0F 1F needs at least a P6 and its longer forms use a SIB byte, 16-bit code keeps single byte NOPs
+    if (mode == BitMode::Bits16)
+    {
+        out.resize(out.size() + length, 0x90);
+        return;
+    }
 
-std::vector<uint8_t> x86::Encoder::EncodePadding(size_t length)
-{
-    std::vector<uint8_t> buffer(length, 0x90);  // TODO: not cool
-    return buffer;
+    size_t offset = out.size();
+    out.resize(offset + length);
+    while (length > 0)
+    {
+        const size_t size = std::min<size_t>(length, 9);
+        std::memcpy(out.data() + offset, multiByteNops[size], size);
+        offset += size;
+        length -= size;
+    }
 }
@@ -3,6 +3,7 @@
 #include "../Encoder.hpp"
 #include <x86/Instructions.hpp>
 #include <tuple>
+#include <unordered_map>
 
 namespace x86
 {
@@ -13,15 +14,33 @@ namespace x86
         ~Encoder() = default;
 
     protected:
+        explicit Encoder(Encoder* owner);
+
         bool OptimizeOffsets(std::vector<Parser::Section>& parsedSections) override;
+        ::Encoder::Encoder* CreateWorker() override;
 
-        std::vector<uint8_t> EncodeInstruction(Parser::Instruction::Instruction& instruction, bool ignoreUnresolved = false, bool optimize = false) override;
-        uint64_t GetSize(Parser::Instruction::Instruction& instruction) override;
-        std::vector<uint8_t> EncodePadding(size_t length) override;
+        ::Encoder::InstructionBuffer EncodeInstruction(Parser::Instruction::Instruction& instruction, bool ignoreUnresolved = false, bool optimize = false) override;
+        void EncodePadding(::Encoder::SectionBuffer& out, size_t length, BitMode mode) override;
 
     private:
         bool instrUse16BitPrefix = false;
 
+        // encodings of 'mov r64, imm', from shortest to longest
+        enum class MovImmForm : uint8_t
+        {
+            ZeroExtended32,     // mov r32, imm32
+            SignExtended32,     // mov r/m64, imm32
+            Imm64               // mov r64, imm64
+        };
+        // workers read the forms of their owner
+        std::unordered_map<const Parser::Instruction::Instruction*, MovImmForm> ownMovImmForms;
+        std::unordered_map<const Parser::Instruction::Instruction*, MovImmForm>& movImmForms = ownMovImmForms;
+        static constexpr size_t maxRelaxationPasses = 16;
+
+        MovImmForm getMovImmForm(const Parser::Instruction::Instruction& instruction) const;
+        static bool fitsMovImmForm(MovImmForm form, Int128 value);
+        bool isMovImm64(const Parser::Instruction::Instruction& instruction);
+
         static constexpr const uint8_t opcodeEscape = 0x0F;
 
         inline uint8_t getRex(bool W, bool R, bool X, bool B)
@@ -51,10 +70,10 @@ namespace x86
         std::tuple<uint8_t, bool, bool> getReg(uint64_t reg);
         uint8_t getRegSize(uint64_t reg, BitMode mode);
 
-        std::vector<uint8_t> EncodeControlInstruction(Parser::Instruction::Instruction& instruction, bool ignoreUnresolved, bool optimize);
-        std::vector<uint8_t> EncodeInterruptInstruction(Parser::Instruction::Instruction& instruction, bool ignoreUnresolved, bool optimize);
-        std::vector<uint8_t> EncodeFlagInstruction(Parser::Instruction::Instruction& instruction, bool ignoreUnresolved, bool optimize);
-        std::vector<uint8_t> EncodeStackInstruction(Parser::Instruction::Instruction& instruction, bool ignoreUnresolved, bool optimize);
-        std::vector<uint8_t> EncodeDataInstruction(Parser::Instruction::Instruction& instruction, bool ignoreUnresolved, bool optimize);
+        ::Encoder::InstructionBuffer EncodeControlInstruction(Parser::Instruction::Instruction& instruction, bool ignoreUnresolved, bool optimize);
+        ::Encoder::InstructionBuffer EncodeInterruptInstruction(Parser::Instruction::Instruction& instruction, bool ignoreUnresolved, bool optimize);
+        ::Encoder::InstructionBuffer EncodeFlagInstruction(Parser::Instruction::Instruction& instruction, bool ignoreUnresolved, bool optimize);
+        ::Encoder::InstructionBuffer EncodeStackInstruction(Parser::Instruction::Instruction& instruction, bool ignoreUnresolved, bool optimize);
+        ::Encoder::InstructionBuffer EncodeDataInstruction(Parser::Instruction::Instruction& instruction, bool ignoreUnresolved, bool optimize);
     };
 }
@@ -1,6 +1,6 @@
 #include "Encoder.hpp"
 
-std::vector<uint8_t> x86::Encoder::EncodeFlagInstruction(Parser::Instruction::Instruction& instruction, bool ignoreUnresolved, bool optimize)
+::Encoder::InstructionBuffer x86::Encoder::EncodeFlagInstruction(Parser::Instruction::Instruction& instruction, bool ignoreUnresolved, bool optimize)
 {
     switch (instruction.mnemonic)
     {
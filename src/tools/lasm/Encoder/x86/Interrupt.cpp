@@ -1,6 +1,6 @@
 #include "Encoder.hpp"
 
-std::vector<uint8_t> x86::Encoder::EncodeInterruptInstruction(Parser::Instruction::Instruction& instruction, bool ignoreUnresolved, bool optimize)
+::Encoder::InstructionBuffer x86::Encoder::EncodeInterruptInstruction(Parser::Instruction::Instruction& instruction, bool ignoreUnresolved, bool optimize)
 {
     switch (instruction.mnemonic)
     {
@@ -23,16 +23,9 @@ std::vector<uint8_t> x86::Encoder::EncodeInterruptInstruction(Parser::Instructio
             ::Encoder::Evaluation interruptEval = Evaluate(immediate, bytesWritten, sectionOffset, currentSection);
             if (interruptEval.useOffset)
             {
-                interrupt = interruptEval.offset;
-                ::Encoder::Relocation reloc;
-                reloc.offsetInSection = sectionOffset + 1; // opcode
-                reloc.addend = interruptEval.offset;
-                reloc.addendInCode = true;
-                reloc.section = *currentSection;
-                reloc.usedSection = interruptEval.usedSection;
-                reloc.type = ::Encoder::RelocationType::Absolute;
+                ::Encoder::Relocation reloc = makeRelocation(interruptEval, sectionOffset + 1, *currentSection); // opcode
                 reloc.size = ::Encoder::RelocationSize::Bit8;
-                reloc.isExtern = interruptEval.isExtern;
+                interrupt = static_cast<uint8_t>(reloc.addend);
                 relocations.push_back(std::move(reloc));
             }
             else
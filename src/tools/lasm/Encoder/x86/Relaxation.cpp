@@ -0,0 +1,303 @@
+#include "Encoder.hpp"
+
+#include <x86/Registers.hpp>
+#include <limits>
+
+bool x86::Encoder::isMovImm64(const Parser::Instruction::Instruction& instruction)
+{
+    if (instruction.mnemonic != Instructions::MOV || instruction.operands.size() != 2)
+        return false;
+    if (!std::holds_alternative<Parser::Instruction::Register>(instruction.operands[0])
+     || !std::holds_alternative<Parser::Immediate>(instruction.operands[1]))
+        return false;
+
+    switch (std::get<Parser::Instruction::Register>(instruction.operands[0]).reg)
+    {
+        case RAX: case RCX:
+        case RDX: case RBX:
+        case RSP: case RBP:
+        case RSI: case RDI:
+        case R8: case R9:
+        case R10: case R11:
+        case R12: case R13:
+        case R14: case R15:
+            return instruction.bits == BitMode::Bits64;
+
+        default:
+            return false;
+    }
+}
+
+x86::Encoder::MovImmForm x86::Encoder::getMovImmForm(const Parser::Instruction::Instruction& instruction) const
+{
+    auto it = movImmForms.find(&instruction);
+    return it != movImmForms.end() ? it->second : MovImmForm::Imm64;
+}
+
+bool x86::Encoder::fitsMovImmForm(MovImmForm form, Int128 value)
+{
+    if (form == MovImmForm::Imm64)
+        return true;
+
+    if (value < static_cast<Int128>(std::numeric_limits<int64_t>::min())
+     || value > static_cast<Int128>(std::numeric_limits<uint64_t>::max()))
+        return false;
+
+    const uint64_t bits = static_cast<uint64_t>(value);
+    const int64_t sign = static_cast<int64_t>(bits);
+
+    if (form == MovImmForm::ZeroExtended32)
+        return bits <= std::numeric_limits<uint32_t>::max();
+
+    return sign >= std::numeric_limits<int32_t>::min() && sign <= std::numeric_limits<int32_t>::max();
+}
+
+// Every 'mov r64, imm' starts in its shortest form and only grows when its value doesn't fit.
+// Growing shifts everything after it, which can change label differences, so this repeats until
+// nothing grows anymore. Forms never shrink again, so it always ends, the pass cap only bounds the work.
+bool x86::Encoder::OptimizeOffsets(std::vector<Parser::Section>& parsedSections)
+{
+    movImmForms.clear();
+    relaxationStats = {};
+    sectionSizes.clear();
+
+    struct Item
+    {
+        Parser::SectionEntry* entry;
+        uint64_t offset = 0;
+        uint64_t size = 0;
+
+        ::Encoder::Label* label = nullptr;
+        ::Encoder::Constant* constant = nullptr;
+
+        // size of one copy, the count can depend on the position
+        const Parser::Repetition* repetition = nullptr;
+        uint64_t unit = 0;
+    };
+
+    struct Candidate
+    {
+        size_t section;
+        size_t item;
+        Parser::Instruction::Instruction* instruction;
+    };
+
+    std::vector<Candidate> candidates;
+    for (size_t s = 0; s < parsedSections.size(); s++)
+    {
+        for (size_t i = 0; i < parsedSections[s].entries.size(); i++)
+        {
+            Parser::SectionEntry& entry = parsedSections[s].entries[i];
+            if (!std::holds_alternative<Parser::Instruction::Instruction>(entry))
+                continue;
+
+            // a repeated instruction has to keep a single size for all its copies
+            if (i != 0 && std::holds_alternative<Parser::Repetition>(parsedSections[s].entries[i - 1]))
+                continue;
+
+            Parser::Instruction::Instruction& instruction = std::get<Parser::Instruction::Instruction>(entry);
+            if (isMovImm64(instruction))
+            {
+                movImmForms[&instruction] = MovImmForm::ZeroExtended32;
+                candidates.push_back({s, i, &instruction});
+            }
+        }
+    }
+
+    // without anything to relax, EncodeFinal lays out the code on its own,
+    // unless the sections are encoded in parallel, that needs every label placed up front
+    if (candidates.empty() && !ShouldEncodeInParallel(parsedSections))
+        return false;
+
+    relaxationStats.candidates = candidates.size();
+
+    auto measure = [this](Parser::SectionEntry& entry) -> uint64_t
+    {
+        if (std::holds_alternative<Parser::Instruction::Instruction>(entry))
+            return EncodeInstruction(std::get<Parser::Instruction::Instruction>(entry), true).size();
+        if (std::holds_alternative<Parser::DataDefinition>(entry))
+        {
+            const Parser::DataDefinition& dataDefinition = std::get<Parser::DataDefinition>(entry);
+            if (!dataDefinition.reserved)
+                return dataDefinition.size * dataDefinition.values.size();
+        }
+        return 0;
+    };
+
+    // sizes of everything but alignments and repetitions are fixed, measure them once
+    std::vector<std::vector<Item>> layout(parsedSections.size());
+    bytesWritten = 0;
+    for (size_t s = 0; s < parsedSections.size(); s++)
+    {
+        Parser::Section& section = parsedSections[s];
+        sectionStarts[section.name] = bytesWritten;
+        currentSection = &section.name;
+        sectionOffset = 0;
+
+        std::vector<Item>& items = layout[s];
+        items.reserve(section.entries.size());
+        for (size_t i = 0; i < section.entries.size(); i++)
+        {
+            Parser::SectionEntry& entry = section.entries[i];
+            Item item;
+            item.entry = &entry;
+
+            if (std::holds_alternative<Parser::Repetition>(entry))
+            {
+                // the repeated entry only counts through the repetition, sized with the alignments
+                item.repetition = &std::get<Parser::Repetition>(entry);
+                if (i + 1 < section.entries.size())
+                {
+                    item.unit = measure(section.entries[i + 1]);
+                    items.push_back(item);
+
+                    item = Item();
+                    item.entry = &section.entries[++i];
+                }
+            }
+            else if (std::holds_alternative<Parser::Instruction::Instruction>(entry) || std::holds_alternative<Parser::DataDefinition>(entry))
+                item.size = measure(entry);
+            else if (std::holds_alternative<Parser::Label>(entry))
+            {
+                item.label = findLabel(std::get<Parser::Label>(entry).name);
+            }
+            else if (std::holds_alternative<Parser::Constant>(entry))
+            {
+                item.constant = findConstant(std::get<Parser::Constant>(entry).name);
+            }
+
+            sectionOffset += item.size;
+            bytesWritten += item.size;
+            items.push_back(item);
+        }
+    }
+
+    constexpr size_t clean = std::numeric_limits<size_t>::max();
+    std::vector<size_t> firstDirty(parsedSections.size(), 0);
+
+    // recomputes offsets from the first changed item of each section on
+    auto propagate = [&]()
+    {
+        bytesWritten = 0;
+        for (size_t s = 0; s < parsedSections.size(); s++)
+        {
+            const std::string& name = parsedSections[s].name;
+            const uint64_t start = bytesWritten;
+            sectionStarts[name] = start;
+            currentSection = &name;
+
+            std::vector<Item>& items = layout[s];
+            const size_t from = std::min(firstDirty[s], items.size());
+            uint64_t offset = from == 0 ? 0 : items[from - 1].offset + items[from - 1].size;
+
+            for (size_t i = from; i < items.size(); i++)
+            {
+                Item& item = items[i];
+                item.offset = offset;
+
+                if (std::holds_alternative<Parser::Alignment>(*item.entry))
+                {
+                    const Parser::Alignment& alignment = std::get<Parser::Alignment>(*item.entry);
+                    const Int128 align = Evaluate(alignment.align, start + offset, offset, currentSection).result;
+                    if (align <= 0)
+                        throw Exception::SemanticError("Alignment cannot be zero or lower", alignment.lineNumber, alignment.column);
+
+                    const Int128 offset128 = static_cast<Int128>(offset);
+                    item.size = static_cast<uint64_t>((align - (offset128 % align)) % align);
+                }
+                else if (item.repetition)
+                {
+                    // counts that can't be known yet are left to EncodeFinal to report
+                    item.size = 0;
+                    if (Resolvable(item.repetition->count))
+                    {
+                        const Int128 count = Evaluate(item.repetition->count, start + offset, offset, currentSection).result;
+                        if (count > 0 && count <= static_cast<Int128>(std::numeric_limits<uint64_t>::max() / std::max<uint64_t>(item.unit, 1)))
+                            item.size = item.unit * static_cast<uint64_t>(count);
+                    }
+                }
+                else if (item.label)
+                {
+                    item.label->offset = offset;
+                    item.label->resolved = true;
+                }
+                else if (item.constant)
+                    item.constant->offset = offset;
+
+                offset += item.size;
+            }
+
+            // a section moves as a whole when an earlier one grew
+            for (Item& item : items)
+                if (item.constant)
+                    item.constant->bytesWritten = start + item.offset;
+
+            bytesWritten += items.empty() ? 0 : items.back().offset + items.back().size;
+        }
+        std::fill(firstDirty.begin(), firstDirty.end(), clean);
+    };
+
+    while (true)
+    {
+        propagate();
+
+        // constants that depend on positions have to follow the new layout
+        for (::Encoder::Constant& constant : constants)
+        {
+            if (constant.prePass) continue;
+            constant.resolved = false;
+            constant.useOffset = false;
+            constant.relocationPossible = false;
+        }
+        resolveConstants(true);
+
+        relaxationStats.passes++;
+        const bool giveUp = relaxationStats.passes >= maxRelaxationPasses;
+
+        bool changed = false;
+        for (const Candidate& candidate : candidates)
+        {
+            MovImmForm& form = movImmForms[candidate.instruction];
+            if (form == MovImmForm::Imm64)
+                continue;
+
+            Item& item = layout[candidate.section][candidate.item];
+            MovImmForm needed = MovImmForm::Imm64;
+
+            const Parser::Immediate& immediate = std::get<Parser::Immediate>(candidate.instruction->operands[1]);
+            if (!giveUp && Resolvable(immediate))
+            {
+                currentSection = &parsedSections[candidate.section].name;
+                sectionOffset = item.offset;
+                bytesWritten = sectionStarts[*currentSection] + item.offset;
+
+                // relocated values need the full 64 bits
+                const ::Encoder::Evaluation eval = Evaluate(immediate, bytesWritten, sectionOffset, currentSection);
+                if (!eval.useOffset)
+                {
+                    if (fitsMovImmForm(form, eval.result)) continue;
+                    if (form == MovImmForm::ZeroExtended32 && fitsMovImmForm(MovImmForm::SignExtended32, eval.result))
+                        needed = MovImmForm::SignExtended32;
+                }
+            }
+
+            form = needed;
+            item.size = EncodeInstruction(*candidate.instruction, true).size();
+            firstDirty[candidate.section] = std::min(firstDirty[candidate.section], candidate.item + 1);
+            changed = true;
+        }
+
+        if (!changed)
+            break;
+    }
+
+    for (const Candidate& candidate : candidates)
+        if (movImmForms[candidate.instruction] != MovImmForm::Imm64)
+            relaxationStats.shrunk++;
+
+    sectionSizes.reserve(layout.size());
+    for (const std::vector<Item>& items : layout)
+        sectionSizes.push_back(items.empty() ? 0 : items.back().offset + items.back().size);
+
+    return true;
+}
@@ -4,15 +4,15 @@
 #include <limits>
 #include <cstring>
 
-void appendImmediate(std::vector<uint8_t> &buf, uint64_t value, uint32_t sizeInBits)
+void appendImmediate(::Encoder::InstructionBuffer &buf, uint64_t value, uint32_t sizeInBits)
 {
     uint32_t sizeInBytes = sizeInBits / 8;
-    size_t oldSize = buf.size();
-    buf.resize(oldSize + sizeInBytes);
-    std::memcpy(buf.data() + oldSize, &value, sizeInBytes);
+    uint8_t bytes[sizeof(value)];
+    std::memcpy(bytes, &value, sizeof(value));
+    buf.append(bytes, sizeInBytes);
 }
 
-std::vector<uint8_t> x86::Encoder::EncodeDataInstruction(Parser::Instruction::Instruction& instruction, bool ignoreUnresolved, bool optimize)
+::Encoder::InstructionBuffer x86::Encoder::EncodeDataInstruction(Parser::Instruction::Instruction& instruction, bool ignoreUnresolved, bool optimize)
 {
     switch (instruction.mnemonic)
     {
@@ -24,7 +24,7 @@ std::vector<uint8_t> x86::Encoder::EncodeDataInstruction(Parser::Instruction::In
             Parser::Instruction::Operand destinationOperand = instruction.operands[0];
             Parser::Instruction::Operand sourceOperand = instruction.operands[1];
 
-            std::vector<uint8_t> instr;
+            ::Encoder::InstructionBuffer instr;
 
             if (std::holds_alternative<Parser::Instruction::Register>(destinationOperand))
             {
@@ -575,9 +575,31 @@ std::vector<uint8_t> x86::Encoder::EncodeDataInstruction(Parser::Instruction::In
                         default: throw Exception::InternalError("Unknown register", instruction.lineNumber, instruction.column);
                     }
 
+                    // shorter forms of 'mov r64, imm' picked by OptimizeOffsets
+                    const MovImmForm form = sizeInBits == 64 ? getMovImmForm(instruction) : MovImmForm::Imm64;
+                    bool useModRM = false;
+                    uint8_t modrm = 0;
+                    if (form == MovImmForm::ZeroExtended32)
+                    {
+                        // mov r32, imm32 clears the upper half
+                        rexW = false;
+                        useREX = rexB;
+                        sizeInBits = 32;
+                        max = std::numeric_limits<uint32_t>::max();
+                    }
+                    else if (form == MovImmForm::SignExtended32)
+                    {
+                        // mov r/m64, imm32
+                        useModRM = true;
+                        modrm = getModRM(Mod::REGISTER, 0, opcode - 0xB8);
+                        opcode = 0xC7;
+                        sizeInBits = 32;
+                    }
+
                     if (useREX) instr.push_back(getRex(rexW, rexR, rexX, rexB));
                     if (useOpcodeEscape) instr.push_back(opcodeEscape);
                     instr.push_back(opcode);
+                    if (useModRM) instr.push_back(modrm);
                     
                     uint64_t value = 0;
                     
@@ -586,15 +608,8 @@ std::vector<uint8_t> x86::Encoder::EncodeDataInstruction(Parser::Instruction::In
                         ::Encoder::Evaluation eval = Evaluate(srcImm, bytesWritten, sectionOffset, currentSection);
                         if (eval.useOffset)
                         {
-                            value = eval.offset; // TODO overflow
-                            ::Encoder::Relocation reloc;
-                            reloc.offsetInSection = sectionOffset + instr.size() + (instrUse16BitPrefix ? 1 : 0);
-                            reloc.addend = eval.offset;
-                            reloc.addendInCode = true;
-                            reloc.section = *currentSection;
-                            reloc.usedSection = eval.usedSection;
-                            reloc.type = ::Encoder::RelocationType::Absolute;
-                            reloc.isExtern = eval.isExtern;
+                            ::Encoder::Relocation reloc = makeRelocation(eval, sectionOffset + instr.size() + (instrUse16BitPrefix ? 1 : 0), *currentSection);
+                            value = reloc.addend; // TODO overflow
                             switch (sizeInBits)
                             {
                                 case 8: reloc.size = ::Encoder::RelocationSize::Bit8; break;
@@ -611,6 +626,8 @@ std::vector<uint8_t> x86::Encoder::EncodeDataInstruction(Parser::Instruction::In
 
                             // FIXME
                             if (interrupt128 > max) throw Exception::SemanticError("Operand too large for instruction", instruction.lineNumber, instruction.column);
+                            if (!fitsMovImmForm(form, interrupt128))
+                                throw Exception::InternalError("Operand doesn't fit the relaxed form of 'mov'", instruction.lineNumber, instruction.column);
 
                             value = static_cast<uint64_t>(interrupt128);
                         }
@@ -1,6 +1,8 @@
 #include "ELFWriter.hpp"
+#include "StringTable.hpp"
 
 #include <cstring>
+#include <algorithm>
 
 ELF::Writer::Writer(const Context &_context, Architecture _arch, BitMode _bits, Format _format, std::ostream *_file, const Parser::Parser *_parser, const Encoder::Encoder *_encoder)
     : ::Output::Writer::Writer(_context, _arch, _bits, _format, _file, _parser, _encoder)
@@ -9,35 +11,40 @@ ELF::Writer::Writer(const Context &_context, Architecture _arch, BitMode _bits,
 
 void ELF::Writer::Write()
 {
-    constexpr std::streamoff alignTo = 0x10;
-    constexpr uint64_t alignment = static_cast<uint64_t>(alignTo);
+    if (bits == BitMode::Bits16 || bits == BitMode::Bits32)
+        WriteAs<ELF32>();
+    else if (bits == BitMode::Bits64)
+        WriteAs<ELF64>();
+    else throw Exception::InternalError("Unknown bit mode", -1, -1);
+}
+
+template <typename Class>
+void ELF::Writer::WriteAs()
+{
+    using Word = typename Class::Word;
+    using SectionHeader = typename Class::SectionHeader;
+    using SymbolEntry = typename Class::SymbolEntry;
+
+    constexpr uint64_t alignment = 0x10;
 
-    std::vector<Encoder::Section> eSections = encoder->getSections();
-    const std::vector<Encoder::Encoder::Symbol>& symbols = encoder->getSymbols();
+    const std::vector<Encoder::Section>& eSections = encoder->getSections();
+    const std::vector<Encoder::Symbol>& symbols = encoder->getSymbols();
+    const std::vector<Encoder::Label>& labels = encoder->getLabels();
+    const std::vector<Encoder::Constant>& constants = encoder->getConstants();
     const std::vector<Encoder::Relocation>& relocations = encoder->getRelocations();
 
-    Section nullSection;
+    std::vector<Section<Class>> sections;
+    std::vector<RelocationSection<Class>> relocationSections;
+
+    std::vector<SymbolEntry> localSymbols;
+    std::vector<SymbolEntry> globalSymbols;
+    std::vector<SymbolEntry> weakSymbols;
+
+    Section<Class> nullSection;
     nullSection.writeBuffer = false;
     nullSection.nullSection = true;
-    if (bits == BitMode::Bits16 || bits == BitMode::Bits32)
     {
-        SectionHeader32 header;
-        header.OffsetInSectionNameStringTable = 0;
-        header.Type = 0;
-        header.Flags = 0;
-        header.VirtualAddress = 0;
-        header.Offset = 0;
-        header.SectionSize = 0;
-        header.LinkIndex = 0;
-        header.Info = 0;
-        header.AddressAlignment = 0;
-        header.EntrySize = 0;
-        
-        nullSection.header = header;
-    }
-    else if (bits == BitMode::Bits64)
-    {
-        SectionHeader64 header;
+        SectionHeader header;
         header.OffsetInSectionNameStringTable = 0;
         header.Type = 0;
         header.Flags = 0;
@@ -51,370 +58,168 @@ void ELF::Writer::Write()
 
         nullSection.header = header;
     }
-    else throw Exception::InternalError("Unknown bit mode", -1, -1);
-
     sections.push_back(std::move(nullSection));
 
-    std::vector<uint8_t> shstrtabBuffer;
-    shstrtabBuffer.push_back(0);
+    // names are handles into the string tables until those are finalized
+    StringTable shstrtabTable;
+    StringTable strtabTable;
 
     std::vector<uint8_t> symtabBuffer;
-    if (bits == BitMode::Bits16 || bits == BitMode::Bits32)
     {
-        Symbol::Entry32 entry;
+        SymbolEntry entry;
         entry.OffsetInNameStringTable = 0;
         entry.Value = 0;
         entry.Size = 0;
         entry.Info = 0;
         entry.Other = 0;
         entry.IndexInSectionHeaderTable = 0;
-        
-        localSymbols.push_back(std::move(entry));
-    }
-    else if (bits == BitMode::Bits64)
-    {
-        Symbol::Entry64 entry;
-        entry.OffsetInNameStringTable = 0;
-        entry.Info = 0;
-        entry.Other = 0;
-        entry.IndexInSectionHeaderTable = 0;
-        entry.Value = 0;
-        entry.Size = 0;
-        
-        localSymbols.push_back(std::move(entry));
-    }
-    else throw Exception::InternalError("Unknown bit mode", -1, -1);
-
-    std::vector<uint8_t> strtabBuffer;
-    strtabBuffer.push_back(0);
-
 
-    uint32_t filenameOffset = static_cast<uint32_t>(strtabBuffer.size());
-    strtabBuffer.insert(strtabBuffer.end(), context.filename.begin(), context.filename.end());
-    strtabBuffer.push_back(0);
+        localSymbols.push_back(entry);
+    }
 
-    if (bits == BitMode::Bits16 || bits == BitMode::Bits32)
+    const uint32_t filenameOffset = strtabTable.add(context.filename);
     {
-        Symbol::Entry32 entry;
+        SymbolEntry entry;
         entry.OffsetInNameStringTable = filenameOffset;
         entry.Value = 0;
         entry.Size = 0;
         entry.Info = Symbol::SetInfo(Symbol::Bind::LOCAL, Symbol::Type::FILE);
         entry.Other = 0;
         entry.IndexInSectionHeaderTable = Symbol::XINDEX;
-        
-        localSymbols.push_back(std::move(entry));
-    }
-    else if (bits == BitMode::Bits64)
-    {
-        Symbol::Entry64 entry;
-        entry.OffsetInNameStringTable = filenameOffset;
-        entry.Info = Symbol::SetInfo(Symbol::Bind::LOCAL, Symbol::Type::FILE);
-        entry.Other = 0;
-        entry.IndexInSectionHeaderTable = Symbol::XINDEX;
-        entry.Value = 0;
-        entry.Size = 0;
-        
-        localSymbols.push_back(std::move(entry));
-    }
-    else throw Exception::InternalError("Unknown bit mode", -1, -1);
 
+        localSymbols.push_back(entry);
+    }
 
     std::unordered_map<std::string, uint16_t> sectionIndexes;
     std::unordered_map<std::string, uint64_t> sectionSymbolIndex;
 
     for (size_t i = 0; i < eSections.size(); i++)
     {
-        Encoder::Section& section = eSections[i];
-        Section s;
+        const Encoder::Section& section = eSections[i];
+        Section<Class> s;
         s.buffer = &section.buffer;
         s.name = section.name;
 
-        uint32_t nameOffset = static_cast<uint32_t>(shstrtabBuffer.size());
-        shstrtabBuffer.insert(shstrtabBuffer.end(), section.name.begin(), section.name.end());
-        shstrtabBuffer.push_back(0);
-
-        if (bits == BitMode::Bits16 || bits == BitMode::Bits32)
-        {
-            SectionHeader32 header;
-            header.OffsetInSectionNameStringTable = nameOffset;
-            header.Type = getSectionType(section.name);
-            header.Flags = static_cast<uint32_t>(getSectionFlags(section.name));
-            header.VirtualAddress = 0;
-            if (section.isInitialized)
-                header.SectionSize = static_cast<uint32_t>(section.buffer.size());
-            else
-                header.SectionSize = static_cast<uint32_t>(section.reservedSize);
-            header.LinkIndex = 0;                   // TODO
-            header.Info = 0;                        // TODO
-            header.AddressAlignment = section.align;
-            header.EntrySize = 0;
-            
-            s.header = header;
-
-
-            Symbol::Entry32 entry;
-            entry.OffsetInNameStringTable = 0;
-            entry.Value = 0;
-            entry.Size = 0;
-            entry.Info = Symbol::SetInfo(Symbol::Bind::LOCAL, Symbol::Type::SECTION);
-            entry.Other = 0;
-            entry.IndexInSectionHeaderTable = i + 1; // TODO: ugly
-            
-            sectionSymbolIndex[section.name] = static_cast<uint64_t>(localSymbols.size());
-            localSymbols.push_back(std::move(entry));
-        }
-        else if (bits == BitMode::Bits64)
-        {
-            SectionHeader64 header;
-            header.OffsetInSectionNameStringTable = nameOffset;
-            header.Type = getSectionType(section.name);
-            header.Flags = getSectionFlags(section.name);
-            header.VirtualAddress = 0;
-            if (section.isInitialized)
-                header.SectionSize = static_cast<uint64_t>(section.buffer.size());
-            else
-                header.SectionSize = static_cast<uint64_t>(section.reservedSize);
-            header.LinkIndex = 0;                   // TODO
-            header.Info = 0;                        // TODO
-            header.AddressAlignment = section.align;
-            header.EntrySize = 0;
+        SectionHeader header;
+        header.OffsetInSectionNameStringTable = shstrtabTable.add(section.name);
+        header.Type = getSectionType(section.name);
+        header.Flags = static_cast<Word>(getSectionFlags(section.name));
+        header.VirtualAddress = 0;
+        if (section.isInitialized)
+            header.SectionSize = static_cast<Word>(section.buffer.size());
+        else
+            header.SectionSize = static_cast<Word>(section.reservedSize);
+        header.LinkIndex = 0;                   // TODO
+        header.Info = 0;                        // TODO
+        header.AddressAlignment = static_cast<Word>(section.align);
+        header.EntrySize = 0;
 
-            s.header = header;
+        s.header = header;
 
+        SymbolEntry entry;
+        entry.OffsetInNameStringTable = 0;
+        entry.Value = 0;
+        entry.Size = 0;
+        entry.Info = Symbol::SetInfo(Symbol::Bind::LOCAL, Symbol::Type::SECTION);
+        entry.Other = 0;
+        entry.IndexInSectionHeaderTable = static_cast<uint16_t>(i + 1); // TODO: ugly
 
-            Symbol::Entry64 entry;
-            entry.OffsetInNameStringTable = 0;
-            entry.Info = Symbol::SetInfo(Symbol::Bind::LOCAL, Symbol::Type::SECTION);
-            entry.Other = 0;
-            entry.IndexInSectionHeaderTable = i + 1; // TODO: ugly
-            entry.Value = 0;
-            entry.Size = 0;
-            
-            sectionSymbolIndex[section.name] = static_cast<uint64_t>(localSymbols.size());
-            localSymbols.push_back(std::move(entry));
-        }
-        else throw Exception::InternalError("Unknown bit mode", -1, -1);
+        sectionSymbolIndex[section.name] = static_cast<uint64_t>(localSymbols.size());
+        localSymbols.push_back(entry);
 
         sectionIndexes[section.name] = static_cast<uint16_t>(sections.size());
         sections.push_back(std::move(s));
     }
 
     // Symbols
-    std::unordered_map<std::string, uint32_t> labelNameOffsets;
-
-    for (const auto& symbol : symbols)
-    {
-        uint32_t offset = static_cast<uint32_t>(strtabBuffer.size());
-
-        if (std::holds_alternative<Encoder::Label*>(symbol))
-        {
-            const Encoder::Label* label = std::get<Encoder::Label*>(symbol);
-            if (label->isExtern && !label->externUsed) continue;
-            strtabBuffer.insert(strtabBuffer.end(), label->name.begin(), label->name.end());
-            strtabBuffer.push_back(0);
-            labelNameOffsets[label->name] = offset;
-        }
-        else if (std::holds_alternative<Encoder::Constant*>(symbol))
-        {
-            const Encoder::Constant* constant = std::get<Encoder::Constant*>(symbol);
-            strtabBuffer.insert(strtabBuffer.end(), constant->name.begin(), constant->name.end());
-            strtabBuffer.push_back(0);
-            labelNameOffsets[constant->name] = offset;
-        }
-    }
-
     std::unordered_map<std::string, uint64_t> externLabelIndex;
 
     for (const auto& symbol : symbols)
     {
-        if (std::holds_alternative<Encoder::Label*>(symbol))
+        if (symbol.kind == Encoder::SymbolKind::Label)
         {
-            const Encoder::Label* label = std::get<Encoder::Label*>(symbol);
+            const Encoder::Label* label = &labels[symbol.index];
             if (label->isExtern && !label->externUsed) continue;
-            auto it = labelNameOffsets.find(label->name);
-            if (it == labelNameOffsets.end()) throw Exception::InternalError("Couldn't find offset for label in .strtab", -1, -1);
-            uint32_t nameOffset = it->second;
 
-            if (bits == BitMode::Bits16 || bits == BitMode::Bits32)
+            SymbolEntry entry;
+            entry.OffsetInNameStringTable = strtabTable.add(label->name);
+            entry.Value = static_cast<Word>(label->offset);
+            entry.Size = 0;
+            entry.Info = Symbol::SetInfo((label->isGlobal || label->isExtern) ? Symbol::Bind::GLOBAL : Symbol::Bind::LOCAL, Symbol::Type::NONE);
+            entry.Other = 0;
+            auto it = sectionIndexes.find(label->section);
+            if (it == sectionIndexes.end()) throw Exception::InternalError("Unknown section for label", -1, -1);
+            entry.IndexInSectionHeaderTable = it->second;
+
+            if (label->isExtern)
             {
-                Symbol::Entry32 entry;
-                entry.OffsetInNameStringTable = nameOffset;
-                entry.Value = static_cast<uint32_t>(label->offset);
-                entry.Size = 0;
-                entry.Info = Symbol::SetInfo((label->isGlobal || label->isExtern) ? Symbol::Bind::GLOBAL : Symbol::Bind::LOCAL, Symbol::Type::NONE);
-                entry.Other = 0;
-                auto it = sectionIndexes.find(label->section);
-                if (it == sectionIndexes.end()) throw Exception::InternalError("Unknown section for label", -1, -1);
-                entry.IndexInSectionHeaderTable = it->second;
-                
-                if (label->isExtern)
-                {
-                    entry.Value = 0;
-                    entry.IndexInSectionHeaderTable = Symbol::UNDEFINDEX;
-                    externLabelIndex[label->name] = globalSymbols.size();
-                    globalSymbols.push_back(std::move(entry));
-                }
-                else if (label->isGlobal) globalSymbols.push_back(std::move(entry));
-                else localSymbols.push_back(std::move(entry));
+                entry.Value = 0;
+                entry.IndexInSectionHeaderTable = Symbol::UNDEFINDEX;
+                externLabelIndex[label->name] = globalSymbols.size();
+                globalSymbols.push_back(entry);
             }
-            else if (bits == BitMode::Bits64)
-            {
-                Symbol::Entry64 entry;
-                entry.OffsetInNameStringTable = nameOffset;
-                entry.Info = Symbol::SetInfo((label->isGlobal || label->isExtern) ? Symbol::Bind::GLOBAL : Symbol::Bind::LOCAL, Symbol::Type::NONE);
-                entry.Other = 0;
-                auto it = sectionIndexes.find(label->section);
-                if (it == sectionIndexes.end()) throw Exception::InternalError("Unknown section for label", -1, -1);
-                entry.IndexInSectionHeaderTable = it->second;
-                entry.Value = label->offset;
-                entry.Size = 0;
-                
-                if (label->isExtern)
-                {
-                    entry.Value = 0;
-                    entry.IndexInSectionHeaderTable = Symbol::UNDEFINDEX;
-                    externLabelIndex[label->name] = globalSymbols.size();
-                    globalSymbols.push_back(std::move(entry));
-                }
-                else if (label->isGlobal) globalSymbols.push_back(std::move(entry));
-                else localSymbols.push_back(std::move(entry));
-            }
-            else throw Exception::InternalError("Unknown bit mode", -1, -1);
+            else if (label->isGlobal) globalSymbols.push_back(entry);
+            else localSymbols.push_back(entry);
         }
-        else if (std::holds_alternative<Encoder::Constant*>(symbol))
+        else if (symbol.kind == Encoder::SymbolKind::Constant)
         {
-            const Encoder::Constant* constant = std::get<Encoder::Constant*>(symbol);
-            
-            auto it = labelNameOffsets.find(constant->name);
-            if (it == labelNameOffsets.end()) throw Exception::InternalError("Couldn't find offset for constant in .strtab", -1, -1);
-            uint32_t nameOffset = it->second;
+            const Encoder::Constant* constant = &constants[symbol.index];
 
-            if (bits == BitMode::Bits16 || bits == BitMode::Bits32)
-            {
-                Symbol::Entry32 entry;
-                entry.OffsetInNameStringTable = nameOffset;
-                entry.Value = static_cast<uint32_t>(constant->useOffset ? constant->off : constant->value); // TODO: overflow
-                entry.Size = 0;
-                entry.Info = Symbol::SetInfo(constant->isGlobal ? Symbol::Bind::GLOBAL : Symbol::Bind::LOCAL, Symbol::Type::NONE);
-                entry.Other = 0;
-                if (constant->useOffset)
-                {
-                    auto it = sectionIndexes.find(constant->usedSection);
-                    if (it == sectionIndexes.end()) throw Exception::InternalError("Unknown section for label", -1, -1);
-                    entry.IndexInSectionHeaderTable = it->second;
-                }
-                else entry.IndexInSectionHeaderTable = Symbol::XINDEX;
-                
-                if (constant->isGlobal) globalSymbols.push_back(std::move(entry));
-                else localSymbols.push_back(std::move(entry));
-            }
-            else if (bits == BitMode::Bits64)
+            SymbolEntry entry;
+            entry.OffsetInNameStringTable = strtabTable.add(constant->name);
+            entry.Value = static_cast<Word>(constant->useOffset ? constant->off : constant->value); // TODO: overflow
+            entry.Size = 0;
+            entry.Info = Symbol::SetInfo(constant->isGlobal ? Symbol::Bind::GLOBAL : Symbol::Bind::LOCAL, Symbol::Type::NONE);
+            entry.Other = 0;
+            if (constant->useOffset)
             {
-                Symbol::Entry64 entry;
-                entry.OffsetInNameStringTable = nameOffset;
-                entry.Info = Symbol::SetInfo(constant->isGlobal ? Symbol::Bind::GLOBAL : Symbol::Bind::LOCAL, Symbol::Type::NONE);
-                entry.Other = 0;
-                if (constant->useOffset)
-                {
-                    auto it = sectionIndexes.find(constant->usedSection);
-                    if (it == sectionIndexes.end()) throw Exception::InternalError("Unknown section for label", -1, -1);
-                    entry.IndexInSectionHeaderTable = it->second;
-                }
-                else entry.IndexInSectionHeaderTable = Symbol::XINDEX;
-                entry.Value = constant->useOffset ? constant->off : constant->value;
-                entry.Size = 0;
-                
-                if (constant->isGlobal) globalSymbols.push_back(std::move(entry));
-                else localSymbols.push_back(std::move(entry));
+                auto it = sectionIndexes.find(constant->usedSection);
+                if (it == sectionIndexes.end()) throw Exception::InternalError("Unknown section for label", -1, -1);
+                entry.IndexInSectionHeaderTable = it->second;
             }
-            else throw Exception::InternalError("Unknown bit mode", -1, -1);
+            else entry.IndexInSectionHeaderTable = Symbol::XINDEX;
+
+            if (constant->isGlobal) globalSymbols.push_back(entry);
+            else localSymbols.push_back(entry);
         }
     }
 
     // SHSTRTAB
-    Section shstrtab;
-    shstrtab.buffer = &shstrtabBuffer;
+    Section<Class> shstrtab;
+    shstrtab.buffer = &shstrtabTable.data();
     shstrtab.name = ".shstrtab";
-    std::string shstrtabName = ".shstrtab";
 
-    uint32_t shstrtabNameOffset = static_cast<uint32_t>(shstrtabBuffer.size());
-    shstrtabBuffer.insert(shstrtabBuffer.end(), shstrtabName.begin(), shstrtabName.end());
-    shstrtabBuffer.push_back(0);
+    const uint32_t shstrtabNameOffset = shstrtabTable.add(shstrtab.name);
 
     uint16_t shstrtabIndex = static_cast<uint16_t>(sections.size());
 
     // SYMTAB
-    Section symtab;
+    Section<Class> symtab;
     symtab.buffer = &symtabBuffer;
     symtab.name = ".symtab";
-    std::string symtabName = ".symtab";
     uint32_t symtabIndex = static_cast<uint32_t>(sections.size()) + 1; // TODO: ugly way
 
-    uint32_t symtabNameOffset = static_cast<uint32_t>(shstrtabBuffer.size());
-    shstrtabBuffer.insert(shstrtabBuffer.end(), symtabName.begin(), symtabName.end());
-    shstrtabBuffer.push_back(0);
+    const uint32_t symtabNameOffset = shstrtabTable.add(symtab.name);
 
-    for (const SymbolEntry& symbol : localSymbols)
+    strtabTable.finalize();
+    symtabBuffer.resize((localSymbols.size() + globalSymbols.size() + weakSymbols.size()) * sizeof(SymbolEntry));
+    uint8_t* symbolOut = symtabBuffer.data();
+    for (const std::vector<SymbolEntry>* table : {&localSymbols, &globalSymbols, &weakSymbols})
     {
-        if (std::holds_alternative<Symbol::Entry32>(symbol))
-        {
-            const Symbol::Entry32& entry = std::get<Symbol::Entry32>(symbol);
-            symtabBuffer.resize(symtabBuffer.size() + sizeof(Symbol::Entry32));
-            std::memcpy(symtabBuffer.data() + symtabBuffer.size() - sizeof(Symbol::Entry32), &entry, sizeof(Symbol::Entry32));
-        }
-        else if (std::holds_alternative<Symbol::Entry64>(symbol))
+        for (SymbolEntry entry : *table)
         {
-            const Symbol::Entry64& entry = std::get<Symbol::Entry64>(symbol);
-            symtabBuffer.resize(symtabBuffer.size() + sizeof(Symbol::Entry64));
-            std::memcpy(symtabBuffer.data() + symtabBuffer.size() - sizeof(Symbol::Entry64), &entry, sizeof(Symbol::Entry64));
+            entry.OffsetInNameStringTable = strtabTable.offset(entry.OffsetInNameStringTable);
+            std::memcpy(symbolOut, &entry, sizeof(SymbolEntry));
+            symbolOut += sizeof(SymbolEntry);
         }
-        else throw Exception::InternalError("Unknown symbol entry", -1, -1);
-    }
-
-    for (const SymbolEntry& symbol : globalSymbols)
-    {
-        if (std::holds_alternative<Symbol::Entry32>(symbol))
-        {
-            const Symbol::Entry32& entry = std::get<Symbol::Entry32>(symbol);
-            symtabBuffer.resize(symtabBuffer.size() + sizeof(Symbol::Entry32));
-            std::memcpy(symtabBuffer.data() + symtabBuffer.size() - sizeof(Symbol::Entry32), &entry, sizeof(Symbol::Entry32));
-        }
-        else if (std::holds_alternative<Symbol::Entry64>(symbol))
-        {
-            const Symbol::Entry64& entry = std::get<Symbol::Entry64>(symbol);
-            symtabBuffer.resize(symtabBuffer.size() + sizeof(Symbol::Entry64));
-            std::memcpy(symtabBuffer.data() + symtabBuffer.size() - sizeof(Symbol::Entry64), &entry, sizeof(Symbol::Entry64));
-        }
-        else throw Exception::InternalError("Unknown symbol entry", -1, -1);
-    }
-
-    for (const SymbolEntry& symbol : weakSymbols)
-    {
-        if (std::holds_alternative<Symbol::Entry32>(symbol))
-        {
-            const Symbol::Entry32& entry = std::get<Symbol::Entry32>(symbol);
-            symtabBuffer.resize(symtabBuffer.size() + sizeof(Symbol::Entry32));
-            std::memcpy(symtabBuffer.data() + symtabBuffer.size() - sizeof(Symbol::Entry32), &entry, sizeof(Symbol::Entry32));
-        }
-        else if (std::holds_alternative<Symbol::Entry64>(symbol))
-        {
-            const Symbol::Entry64& entry = std::get<Symbol::Entry64>(symbol);
-            symtabBuffer.resize(symtabBuffer.size() + sizeof(Symbol::Entry64));
-            std::memcpy(symtabBuffer.data() + symtabBuffer.size() - sizeof(Symbol::Entry64), &entry, sizeof(Symbol::Entry64));
-        }
-        else throw Exception::InternalError("Unknown symbol entry", -1, -1);
     }
 
     // STRTAB
-    Section strtab;
-    strtab.buffer = &strtabBuffer;
+    Section<Class> strtab;
+    strtab.buffer = &strtabTable.data();
     strtab.name = ".strtab";
-    std::string strtabName = ".strtab";
 
-    uint32_t strtabNameOffset = static_cast<uint32_t>(shstrtabBuffer.size());
-    shstrtabBuffer.insert(shstrtabBuffer.end(), strtabName.begin(), strtabName.end());
-    shstrtabBuffer.push_back(0);
+    const uint32_t strtabNameOffset = shstrtabTable.add(strtab.name);
 
     // Relocations
     for (const Encoder::Relocation& relocation : relocations)
@@ -422,250 +227,121 @@ void ELF::Writer::Write()
         auto it = sectionIndexes.find(relocation.section);
         if (it == sectionIndexes.end()) throw Exception::InternalError("Section not found", -1, -1);
         const uint16_t sectionIndex = it->second;
-        Section& section = sections[sectionIndex];
+        Section<Class>& section = sections[sectionIndex];
 
         if (!section.hasRelocations) section.hasRelocations = true;
-        if (!section.hasAddend && (bits == BitMode::Bits64 || !relocation.addendInCode)) section.hasAddend = true;
+        if (!section.hasAddend && (Class::alwaysAddend || !relocation.addendInCode)) section.hasAddend = true;
 
-        section.relocations.push_back(relocation);
+        section.relocations.push_back(&relocation);
     }
 
-    for (Section& section : sections)
+    auto getType = [](Encoder::RelocationType type, Encoder::RelocationSize size) -> typename Class::RelocationType
     {
-        if (!section.hasRelocations || section.nullSection) continue;
-        RelocationSection relocSection;
-
-        auto getType32 = [](Encoder::RelocationType type, Encoder::RelocationSize size) -> uint8_t
-        {
-            switch (type)
-            {
-                case Encoder::RelocationType::Absolute:
-                    switch (size)
-                    {
-                        case Encoder::RelocationSize::Bit8: return RelocationType32::R386_ABS8;
-                        case Encoder::RelocationSize::Bit16: return RelocationType32::R386_ABS16;
-                        case Encoder::RelocationSize::Bit32: return RelocationType32::R386_ABS32;
-                        case Encoder::RelocationSize::Bit64: return RelocationType32::R386_ABS32; // FIXME: not very nice way of doing it
-                        default: throw Exception::InternalError("Unknown relocation size", -1, -1);
-                    }
-                default: throw Exception::InternalError("Unknown relocation type", -1, -1);
-            }
-            return RelocationType32::R386_None;
-        };
-
-        auto getType64 = [](Encoder::RelocationType type, Encoder::RelocationSize size) -> uint32_t
+        switch (type)
         {
-            switch (type)
-            {
-                case Encoder::RelocationType::Absolute:
-                    switch (size)
-                    {
-                        case Encoder::RelocationSize::Bit8: return RelocationType64::RX64_ABS8;
-                        case Encoder::RelocationSize::Bit16: return RelocationType64::RX64_ABS16;
-                        case Encoder::RelocationSize::Bit32: return RelocationType64::RX64_ABS32;
-                        case Encoder::RelocationSize::Bit64: return RelocationType64::RX64_ABS64;
-                        default: throw Exception::InternalError("Unknown relocation size", -1, -1);
-                    }
-                default: throw Exception::InternalError("Unknown relocation type", -1, -1);
-            }
-            return RelocationType64::RX64_None;
-        };
-        
-        if (section.hasAddend)
-        {
-            relocSection.name = ".rela" + section.name;
-            for (const Encoder::Relocation& relocation : section.relocations)
-            {
-                uint64_t symbolIndex;
-                if (relocation.isExtern)
-                {
-                    auto it = externLabelIndex.find(relocation.usedSection);
-                    if (it == externLabelIndex.end()) throw Exception::InternalError("Couldn't find index in .symtab", -1, -1);
-                    symbolIndex = it->second + localSymbols.size();
-                }
-                else
-                {
-                    auto it = sectionSymbolIndex.find(relocation.usedSection);
-                    if (it == sectionSymbolIndex.end()) throw Exception::InternalError("Couldn't find index in .symtab", -1, -1);
-                    symbolIndex = it->second;
-                }
-
-                // TODO: check if actual useful
-                // If the relocation has an addend, this code removes it from the code itself
-                switch (relocation.size)
+            case Encoder::RelocationType::Absolute:
+                switch (size)
                 {
-                    case Encoder::RelocationSize::Bit8:
-                    {
-                        std::memset(section.buffer->data() + relocation.offsetInSection, 0, sizeof(uint8_t));
-                        break;
-                    }
-                    case Encoder::RelocationSize::Bit16:
-                    {
-                        std::memset(section.buffer->data() + relocation.offsetInSection, 0, sizeof(uint16_t));
-                        break;
-                    }
-                    case Encoder::RelocationSize::Bit24:
-                    {
-                        std::memset(section.buffer->data() + relocation.offsetInSection, 0, 3);
-                        break;
-                    }
-                    case Encoder::RelocationSize::Bit32:
-                    {
-                        std::memset(section.buffer->data() + relocation.offsetInSection, 0, sizeof(uint32_t));
-                        break;
-                    }
+                    case Encoder::RelocationSize::Bit8: return Class::abs8;
+                    case Encoder::RelocationSize::Bit16: return Class::abs16;
+                    case Encoder::RelocationSize::Bit32: return Class::abs32;
                     case Encoder::RelocationSize::Bit64:
-                    {
-                        std::memset(section.buffer->data() + relocation.offsetInSection, 0, sizeof(uint64_t));
-                        break;
-                    }
+                        if constexpr (Class::relocations64) return Class::abs64;
+                        else throw Exception::SemanticError("Can't use 64-bit relocations with 32-bit ELF output", -1, -1);
+                    default: throw Exception::InternalError("Unknown relocation size", -1, -1);
                 }
-                
-                if (bits == BitMode::Bits16 || bits == BitMode::Bits32)
+            case Encoder::RelocationType::Relative:
+                switch (size)
                 {
-                    RelaEntry32 entry;
-
-                    entry.offset = static_cast<uint32_t>(relocation.offsetInSection); //TODO: handle overflow
-                    entry.addend = static_cast<int32_t>(relocation.addend); //TODO: handle overflow
-
-                    uint8_t type = getType32(relocation.type, relocation.size);
-                    // TODO: handle overflows with symbol
-                    entry.info = SetRelocationInfo32(static_cast<uint32_t>(symbolIndex), type);
-
-                    relocSection.buffer.resize(relocSection.buffer.size() + sizeof(RelaEntry32));
-                    std::memcpy(relocSection.buffer.data() + relocSection.buffer.size() - sizeof(RelaEntry32), &entry, sizeof(RelaEntry32));
+                    case Encoder::RelocationSize::Bit8: return Class::pc8;
+                    case Encoder::RelocationSize::Bit16: return Class::pc16;
+                    case Encoder::RelocationSize::Bit32: return Class::pc32;
+                    case Encoder::RelocationSize::Bit64:
+                        if constexpr (Class::relocations64) return Class::pc64;
+                        else throw Exception::SemanticError("Can't use 64-bit relocations with 32-bit ELF output", -1, -1);
+                    default: throw Exception::InternalError("Unknown relocation size", -1, -1);
                 }
-                else if (bits == BitMode::Bits64)
-                {
-                    RelaEntry64 entry;
+            default: throw Exception::InternalError("Unknown relocation type", -1, -1);
+        }
+    };
 
-                    entry.offset = relocation.offsetInSection;
-                    entry.addend = relocation.addend;
+    for (Section<Class>& section : sections)
+    {
+        if (!section.hasRelocations || section.nullSection) continue;
+        RelocationSection<Class> relocSection;
+        relocSection.name = (section.hasAddend ? ".rela" : ".rel") + section.name;
 
-                    uint32_t type = getType64(relocation.type, relocation.size);
-                    // TODO: handle overflows with symbol
-                    entry.info = SetRelocationInfo64(static_cast<uint32_t>(symbolIndex), type);
+        const size_t entrySize = section.hasAddend ? sizeof(typename Class::RelaEntry) : sizeof(typename Class::RelEntry);
+        relocSection.buffer.resize(section.relocations.size() * entrySize);
+        uint8_t* out = relocSection.buffer.data();
 
-                    relocSection.buffer.resize(relocSection.buffer.size() + sizeof(RelaEntry64));
-                    std::memcpy(relocSection.buffer.data() + relocSection.buffer.size() - sizeof(RelaEntry64), &entry, sizeof(RelaEntry64));
-                }
-                else throw Exception::InternalError("Unknown bit mode", -1, -1);
-            }
-        }
-        else
+        for (const Encoder::Relocation* relocation : section.relocations)
         {
-            relocSection.name = ".rel" + section.name;
-            for (const Encoder::Relocation& relocation : section.relocations)
+            uint64_t symbolIndex;
+            if (relocation->isExtern)
             {
-                uint64_t symbolIndex;
-                if (relocation.isExtern)
-                {
-                    auto it = externLabelIndex.find(relocation.usedSection);
-                    if (it == externLabelIndex.end()) throw Exception::InternalError("Couldn't find index in .symtab", -1, -1);
-                    symbolIndex = it->second + localSymbols.size();
-                }
-                else
-                {
-                    auto it = sectionSymbolIndex.find(relocation.usedSection);
-                    if (it == sectionSymbolIndex.end()) throw Exception::InternalError("Couldn't find index in .symtab", -1, -1);
-                    symbolIndex = it->second;
-                }
-                
-                if (bits == BitMode::Bits16 || bits == BitMode::Bits32)
-                {
-                    RelEntry32 entry;
-                    entry.offset = static_cast<uint32_t>(relocation.offsetInSection); //TODO: handle overflow
-
-                    uint8_t type = getType32(relocation.type, relocation.size);
-                    // TODO: handle overflows with symbol
-                    entry.info = SetRelocationInfo32(static_cast<uint32_t>(symbolIndex), type);
-
-                    relocSection.buffer.resize(relocSection.buffer.size() + sizeof(RelEntry32));
-                    std::memcpy(relocSection.buffer.data() + relocSection.buffer.size() - sizeof(RelEntry32), &entry, sizeof(RelEntry32));
-                }
-                else if (bits == BitMode::Bits64)
-                {
-                    RelEntry64 entry;
-                    entry.offset = relocation.offsetInSection;
+                auto it = externLabelIndex.find(relocation->usedSection);
+                if (it == externLabelIndex.end()) throw Exception::InternalError("Couldn't find index in .symtab", -1, -1);
+                symbolIndex = it->second + localSymbols.size();
+            }
+            else
+            {
+                auto it = sectionSymbolIndex.find(relocation->usedSection);
+                if (it == sectionSymbolIndex.end()) throw Exception::InternalError("Couldn't find index in .symtab", -1, -1);
+                symbolIndex = it->second;
+            }
 
-                    uint32_t type = getType64(relocation.type, relocation.size);
-                    // TODO: handle overflows with symbol
-                    entry.info = SetRelocationInfo64(static_cast<uint32_t>(symbolIndex), type);
+            // TODO: handle overflows with symbol
+            const auto info = Class::relocationInfo(static_cast<uint32_t>(symbolIndex), getType(relocation->type, relocation->size));
 
-                    relocSection.buffer.resize(relocSection.buffer.size() + sizeof(RelEntry64));
-                    std::memcpy(relocSection.buffer.data() + relocSection.buffer.size() - sizeof(RelEntry64), &entry, sizeof(RelEntry64));
-                }
-                else throw Exception::InternalError("Unknown bit mode", -1, -1);
+            if (section.hasAddend)
+            {
+                // the addend is in the entry, so the field in the code is written as zeros
+                section.clearedFields.push_back({relocation->offsetInSection, static_cast<uint64_t>(relocation->size) / 8});
+
+                typename Class::RelaEntry entry;
+                entry.offset = static_cast<Word>(relocation->offsetInSection); // TODO: handle overflow
+                entry.info = info;
+                entry.addend = static_cast<typename Class::Addend>(relocation->addend); // TODO: handle overflow
+                std::memcpy(out, &entry, sizeof(entry));
             }
+            else
+            {
+                typename Class::RelEntry entry;
+                entry.offset = static_cast<Word>(relocation->offsetInSection); // TODO: handle overflow
+                entry.info = info;
+                std::memcpy(out, &entry, sizeof(entry));
+            }
+            out += entrySize;
         }
 
-        uint32_t nameOffset = static_cast<uint32_t>(shstrtabBuffer.size());
-        shstrtabBuffer.insert(shstrtabBuffer.end(), relocSection.name.begin(), relocSection.name.end());
-        shstrtabBuffer.push_back(0);
-
         auto it = sectionIndexes.find(section.name);
         if (it == sectionIndexes.end()) throw Exception::InternalError("Couldn't find section index", -1, -1);
-        const uint32_t sectionIndex = it->second;
 
-        if (bits == BitMode::Bits16 || bits == BitMode::Bits32)
-        {
-            SectionHeader32 header;
-            header.OffsetInSectionNameStringTable = nameOffset;
-            header.Type = section.hasAddend ? SectionType::Rela : SectionType::Rel;
-            header.Flags = 0;
-            header.VirtualAddress = 0;
-            header.SectionSize = static_cast<uint32_t>(relocSection.buffer.size()); // TODO: overflows
-            header.LinkIndex = symtabIndex;
-            header.Info = sectionIndex;
-            header.AddressAlignment = 4;
-            header.EntrySize = section.hasAddend ? sizeof(RelaEntry32) : sizeof(RelEntry32);
-            
-            relocSection.header = header;
-        }
-        else if (bits == BitMode::Bits64)
-        {
-            SectionHeader64 header;
-            header.OffsetInSectionNameStringTable = nameOffset;
-            header.Type = section.hasAddend ? SectionType::Rela : SectionType::Rel;
-            header.Flags = 0;
-            header.VirtualAddress = 0;
-            header.SectionSize = static_cast<uint64_t>(relocSection.buffer.size());
-            header.LinkIndex = symtabIndex;
-            header.Info = sectionIndex;
-            header.AddressAlignment = 8;
-            header.EntrySize = section.hasAddend ? sizeof(RelaEntry64) : sizeof(RelEntry64);
-
-            relocSection.header = header;
-        }
-        else throw Exception::InternalError("Unknown bit mode", -1, -1);
+        SectionHeader header;
+        header.OffsetInSectionNameStringTable = shstrtabTable.add(relocSection.name);
+        header.Type = section.hasAddend ? SectionType::Rela : SectionType::Rel;
+        header.Flags = 0;
+        header.VirtualAddress = 0;
+        header.SectionSize = static_cast<Word>(relocSection.buffer.size()); // TODO: overflows
+        header.LinkIndex = symtabIndex;
+        header.Info = it->second;
+        header.AddressAlignment = Class::tableAlignment;
+        header.EntrySize = static_cast<Word>(entrySize);
 
+        relocSection.header = header;
         relocationSections.push_back(std::move(relocSection));
     }
 
     // back
-    if (bits == BitMode::Bits16 || bits == BitMode::Bits32)
+    shstrtabTable.finalize();
     {
-        SectionHeader32 header;
+        SectionHeader header;
         header.OffsetInSectionNameStringTable = shstrtabNameOffset;
         header.Type = SectionType::StrTab;
         header.Flags = 0;
         header.VirtualAddress = 0;
-        header.SectionSize = static_cast<uint32_t>(shstrtabBuffer.size());
-        header.LinkIndex = 0;
-        header.Info = 0;
-        header.AddressAlignment = 1;
-        header.EntrySize = 0;
-        
-        shstrtab.header = header;
-    }
-    else if (bits == BitMode::Bits64)
-    {
-        SectionHeader64 header;
-        header.OffsetInSectionNameStringTable = shstrtabNameOffset;
-        header.Type = SectionType::StrTab;
-        header.Flags = 0;
-        header.VirtualAddress = 0;
-        header.SectionSize = static_cast<uint32_t>(shstrtabBuffer.size());
+        header.SectionSize = static_cast<uint32_t>(shstrtabTable.data().size());
         header.LinkIndex = 0;
         header.Info = 0;
         header.AddressAlignment = 1;
@@ -673,29 +349,12 @@ void ELF::Writer::Write()
 
         shstrtab.header = header;
     }
-    else throw Exception::InternalError("Unknown bit mode", -1, -1);
     sections.push_back(std::move(shstrtab));
 
     const uint32_t strtabIndex = static_cast<uint32_t>(sections.size()) + 1; // TODO: ugly
 
-    if (bits == BitMode::Bits16 || bits == BitMode::Bits32)
-    {
-        SectionHeader32 header;
-        header.OffsetInSectionNameStringTable = symtabNameOffset;
-        header.Type = SectionType::SymTab;
-        header.Flags = 0;
-        header.VirtualAddress = 0;
-        header.SectionSize = static_cast<uint32_t>(symtabBuffer.size());
-        header.LinkIndex = strtabIndex;
-        header.Info = static_cast<uint32_t>(localSymbols.size());
-        header.AddressAlignment = 4;
-        header.EntrySize = sizeof(Symbol::Entry32);
-        
-        symtab.header = header;
-    }
-    else if (bits == BitMode::Bits64)
     {
-        SectionHeader64 header;
+        SectionHeader header;
         header.OffsetInSectionNameStringTable = symtabNameOffset;
         header.Type = SectionType::SymTab;
         header.Flags = 0;
@@ -703,37 +362,20 @@ void ELF::Writer::Write()
         header.SectionSize = static_cast<uint32_t>(symtabBuffer.size());
         header.LinkIndex = strtabIndex;
         header.Info = static_cast<uint32_t>(localSymbols.size());
-        header.AddressAlignment = 8;
-        header.EntrySize = sizeof(Symbol::Entry64);
+        header.AddressAlignment = Class::tableAlignment;
+        header.EntrySize = sizeof(SymbolEntry);
 
         symtab.header = header;
     }
-    else throw Exception::InternalError("Unknown bit mode", -1, -1);
     sections.push_back(std::move(symtab));
 
-    if (bits == BitMode::Bits16 || bits == BitMode::Bits32)
-    {
-        SectionHeader32 header;
-        header.OffsetInSectionNameStringTable = strtabNameOffset;
-        header.Type = SectionType::StrTab;
-        header.Flags = 0;
-        header.VirtualAddress = 0;
-        header.SectionSize = static_cast<uint32_t>(strtabBuffer.size());
-        header.LinkIndex = 0;
-        header.Info = 0;
-        header.AddressAlignment = 1;
-        header.EntrySize = 0;
-        
-        strtab.header = header;
-    }
-    else if (bits == BitMode::Bits64)
     {
-        SectionHeader64 header;
+        SectionHeader header;
         header.OffsetInSectionNameStringTable = strtabNameOffset;
         header.Type = SectionType::StrTab;
         header.Flags = 0;
         header.VirtualAddress = 0;
-        header.SectionSize = static_cast<uint32_t>(strtabBuffer.size());
+        header.SectionSize = static_cast<uint32_t>(strtabTable.data().size());
         header.LinkIndex = 0;
         header.Info = 0;
         header.AddressAlignment = 1;
@@ -741,85 +383,34 @@ void ELF::Writer::Write()
 
         strtab.header = header;
     }
-    else throw Exception::InternalError("Unknown bit mode", -1, -1);
     sections.push_back(std::move(strtab));
 
     // Relocations
-    for (RelocationSection& relocationSection : relocationSections)
+    for (RelocationSection<Class>& relocationSection : relocationSections)
     {
         // TODO: ugly way to do this
-        Section s;
+        Section<Class> s;
         s.buffer = &relocationSection.buffer;
         s.name = relocationSection.name;
         s.header = relocationSection.header;
         sections.push_back(std::move(s));
     }
 
-    // ELF Header
-    if (bits == BitMode::Bits16 || bits == BitMode::Bits32)
-    {
-        Header32 header;
-        header.Bitness = Bitness::BITS32;
-        header.Endianness = Endianness::LITTLE;
-        header.HeaderVersion = 1;
-        header.ABI = 0; // TODO
-
-        header.Type = Type::RELOCATABLE;
-        switch (arch)
-        {
-            case Architecture::x86:
-                header.InstructionSet = InstructionSet::X86;
-                break;
+    for (Section<Class>& section : sections)
+        section.header.OffsetInSectionNameStringTable = shstrtabTable.offset(section.header.OffsetInSectionNameStringTable);
 
-            case Architecture::ARM:
-                header.InstructionSet = InstructionSet::ARM;
-                break;
-
-            case Architecture::RISC_V:
-                header.InstructionSet = InstructionSet::RISCV;
-                break;
-
-            default: throw Exception::InternalError("Unknown architecture", -1, -1);
-        }
-        header.Version = 1;
-
-        header.ProgramEntryPosition = 0;
-        header.ProgramHeaderTablePosition = 0;
-        header.SectionHeaderTablePosition = 0x40; // TODO: works, but not optimal
-
-        switch (arch)
-        {
-            case Architecture::x86:
-                header.Flags = 0;
-                break;
-
-            case Architecture::ARM:
-                header.Flags = 0; // FIXME
-                break;
-
-            case Architecture::RISC_V:
-                header.Flags = 0; // FIXME
-                break;
-
-            default: throw Exception::InternalError("Unknown architecture", -1, -1);
-        }
-
-        header.HeaderSize = sizeof(Header32);
-
-        //header.ProgramHeaderTableEntrySize = sizeof(ProgramHeader32); TODO
-        header.ProgramHeaderTableEntrySize = 0;
-        header.ProgramHeaderTableEntryCount = 0;
-
-        header.SectionHeaderTableEntrySize = sizeof(SectionHeader32);
-        header.SectionHeaderTableEntryCount = static_cast<uint16_t>(sections.size());
-        header.SectionNamesIndex = shstrtabIndex;
+    // ELF header and section headers, the section contents are referenced from chunks
+    std::vector<uint8_t> headerBuffer;
+    auto appendHeader = [&headerBuffer](const auto& header)
+    {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&header);
+        headerBuffer.insert(headerBuffer.end(), bytes, bytes + sizeof(header));
+    };
 
-        file->write(reinterpret_cast<const char*>(&header), sizeof(header));
-    }
-    else if (bits == BitMode::Bits64)
+    // ELF Header
     {
-        Header64 header;
-        header.Bitness = Bitness::BITS64;
+        typename Class::Header header;
+        header.Bitness = Class::bitness;
         header.Endianness = Endianness::LITTLE;
         header.HeaderVersion = 1;
         header.ABI = 0; // TODO
@@ -828,11 +419,11 @@ void ELF::Writer::Write()
         switch (arch)
         {
             case Architecture::x86:
-                header.InstructionSet = InstructionSet::X64;
+                header.InstructionSet = Class::x86;
                 break;
 
             case Architecture::ARM:
-                header.InstructionSet = InstructionSet::ARM64;
+                header.InstructionSet = Class::arm;
                 break;
 
             case Architecture::RISC_V:
@@ -864,72 +455,74 @@ void ELF::Writer::Write()
             default: throw Exception::InternalError("Unknown architecture", -1, -1);
         }
 
-        header.HeaderSize = sizeof(Header64);
+        header.HeaderSize = sizeof(header);
 
-        //header.ProgramHeaderTableEntrySize = sizeof(ProgramHeader64); TODO
+        //header.ProgramHeaderTableEntrySize = sizeof(ProgramHeader); TODO
         header.ProgramHeaderTableEntrySize = 0;
         header.ProgramHeaderTableEntryCount = 0;
 
-        header.SectionHeaderTableEntrySize = sizeof(SectionHeader64);
+        header.SectionHeaderTableEntrySize = sizeof(SectionHeader);
         header.SectionHeaderTableEntryCount = static_cast<uint16_t>(sections.size());
         header.SectionNamesIndex = shstrtabIndex;
 
-        file->write(reinterpret_cast<const char*>(&header), sizeof(header));
-    }
-    else throw Exception::InternalError("Unknown bit mode", -1, -1);
-    std::streampos pos = file->tellp();
-    std::streamoff padSize = (alignTo - (pos % alignTo)) % alignTo;
-    if (padSize)
-    {
-        std::vector<char> padding(padSize, 0);
-        file->write(padding.data(), padSize);
+        appendHeader(header);
     }
+    headerBuffer.resize((headerBuffer.size() + alignment - 1) / alignment * alignment, 0);
 
     uint64_t offset = 0x40; // TODO: ugly way
-    if (bits == BitMode::Bits16 || bits == BitMode::Bits32)
-        offset += static_cast<uint64_t>(sections.size()) * sizeof(SectionHeader32);
-    else if (bits == BitMode::Bits64)
-        offset += static_cast<uint64_t>(sections.size()) * sizeof(SectionHeader64);
-    else throw Exception::InternalError("Unknown bit mode", -1, -1);
-
+    offset += static_cast<uint64_t>(sections.size()) * sizeof(SectionHeader);
     offset = (offset + alignment - 1) / alignment * alignment;
 
-    for (const Section& section : sections)
+    for (const Section<Class>& section : sections)
     {
-        if (std::holds_alternative<SectionHeader32>(section.header))
-        {
-            SectionHeader32 header = std::get<SectionHeader32>(section.header);
-            if (!section.nullSection) header.Offset = static_cast<uint64_t>(offset);
-
-            file->write(reinterpret_cast<const char*>(&header), sizeof(header));
-        }
-        else if (std::holds_alternative<SectionHeader64>(section.header))
-        {
-            SectionHeader64 header = std::get<SectionHeader64>(section.header);
-            if (!section.nullSection) header.Offset = offset;
-
-            file->write(reinterpret_cast<const char*>(&header), sizeof(header));
-        }
-        else throw Exception::InternalError("Unknown section header", -1, -1);
+        SectionHeader header = section.header;
+        if (!section.nullSection) header.Offset = static_cast<Word>(offset);
+        appendHeader(header);
 
         if (section.writeBuffer) offset += section.buffer->size();
 
         offset = (offset + alignment - 1) / alignment * alignment;
     }
 
-    for (const Section& section : sections)
-    {
-        if (section.writeBuffer) file->write(reinterpret_cast<const char*>(section.buffer->data()), section.buffer->size());
+    headerBuffer.resize((headerBuffer.size() + alignment - 1) / alignment * alignment, 0);
+
+    // the same layout as the headers above, padding and cleared fields come from zeros
+    static const uint8_t zeros[alignment] = {};
+    std::vector<Chunk> chunks;
+    chunks.push_back({headerBuffer.data(), headerBuffer.size()});
+    offset = headerBuffer.size();
 
-        // align to 0x10
-        std::streampos pos = file->tellp();
-        std::streamoff padSize = (alignTo - (pos % alignTo)) % alignTo;
-        if (padSize)
+    for (Section<Class>& section : sections)
+    {
+        if (section.writeBuffer)
         {
-            std::vector<char> padding(padSize, 0);
-            file->write(padding.data(), padSize);
+            const uint8_t* data = section.buffer->data();
+            std::sort(section.clearedFields.begin(), section.clearedFields.end());
+
+            uint64_t written = 0;
+            for (const auto& [fieldOffset, fieldSize] : section.clearedFields)
+            {
+                const uint64_t end = fieldOffset + fieldSize;
+                if (end <= written) continue;
+                if (fieldOffset > written)
+                    chunks.push_back({data + written, fieldOffset - written});
+                chunks.push_back({zeros, end - std::max(fieldOffset, written)});
+                written = end;
+            }
+            if (written < section.buffer->size())
+                chunks.push_back({data + written, section.buffer->size() - written});
+
+            offset += section.buffer->size();
         }
+
+        const uint64_t padding = (alignment - offset % alignment) % alignment;
+        if (padding)
+            chunks.push_back({zeros, padding});
+        offset += padding;
     }
+
+    for (const Chunk& chunk : chunks)
+        file->write(reinterpret_cast<const char*>(chunk.data), static_cast<std::streamsize>(chunk.size));
 }
 
 // TODO: check why .bss doesn't get written, it's right that way, but it wasn't implemented yet
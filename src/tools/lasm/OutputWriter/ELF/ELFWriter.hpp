@@ -5,24 +5,35 @@
 
 namespace ELF
 {
+    template <typename Class>
     struct RelocationSection
     {
         std::vector<uint8_t> buffer;
         std::string name;
 
-        std::variant<SectionHeader32, SectionHeader64> header;
+        typename Class::SectionHeader header;
     };
 
+    // bytes of the output file, written in order
+    struct Chunk
+    {
+        const uint8_t* data;
+        size_t size;
+    };
+
+    template <typename Class>
     struct Section
     {
-        std::vector<uint8_t>* buffer;
+        const std::vector<uint8_t>* buffer;
         std::string name;
 
         bool writeBuffer = true;
         
-        std::variant<SectionHeader32, SectionHeader64> header;
+        typename Class::SectionHeader header;
 
-        std::vector<Encoder::Relocation> relocations;
+        std::vector<const Encoder::Relocation*> relocations;
+        // fields with the addend in the relocation entry, written as zeros: offset and size
+        std::vector<std::pair<uint64_t, uint64_t>> clearedFields;
         bool hasRelocations = false;
         bool hasAddend = false;
 
@@ -38,13 +49,9 @@ namespace ELF
         void Write() override;
 
     protected:
-        std::vector<Section> sections;
-        std::vector<RelocationSection> relocationSections;
-
-        using SymbolEntry = std::variant<Symbol::Entry32, Symbol::Entry64>;
-        std::vector<SymbolEntry> localSymbols;
-        std::vector<SymbolEntry> globalSymbols;
-        std::vector<SymbolEntry> weakSymbols;
+        // Class is ELF32 or ELF64
+        template <typename Class>
+        void WriteAs();
 
         uint64_t getSectionFlags(const std::string& name);
         uint32_t getSectionType(const std::string& name);
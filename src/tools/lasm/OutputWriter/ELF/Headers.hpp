@@ -236,17 +236,24 @@ namespace ELF
     {
         R386_None   = 0,
         R386_ABS32  = 1,
+        R386_PC32   = 2,
         R386_ABS16  = 20,
+        R386_PC16   = 21,
         R386_ABS8   = 22,
+        R386_PC8    = 23,
     };
 
     enum RelocationType64 : uint32_t
     {
         RX64_None   = 0,
         RX64_ABS64  = 1,
+        RX64_PC32   = 2,
         RX64_ABS32  = 10,
         RX64_ABS16  = 12,
+        RX64_PC16   = 13,
         RX64_ABS8   = 14,
+        RX64_PC8    = 15,
+        RX64_PC64   = 24,
     };
 
     struct RelEntry32
@@ -339,4 +346,65 @@ namespace ELF
             uint64_t Size;
         } __attribute__((packed));
     }
+
+    // layouts of the two ELF classes, the writer is instantiated once for each
+    struct ELF32
+    {
+        using Header = Header32;
+        using SectionHeader = SectionHeader32;
+        using SymbolEntry = Symbol::Entry32;
+        using RelEntry = RelEntry32;
+        using RelaEntry = RelaEntry32;
+        using Word = uint32_t;      // addresses, offsets and sizes
+        using Addend = int32_t;
+        using RelocationType = RelocationType32;
+
+        static constexpr uint8_t bitness = Bitness::BITS32;
+        static constexpr InstructionSet x86 = InstructionSet::X86;
+        static constexpr InstructionSet arm = InstructionSet::ARM;
+        static constexpr uint64_t tableAlignment = 4;
+        // the addend stays in the code unless a relocation can't keep it there
+        static constexpr bool alwaysAddend = false;
+
+        // there are no 64-bit relocations, the writer rejects them
+        static constexpr bool relocations64 = false;
+        static constexpr RelocationType abs8 = R386_ABS8;
+        static constexpr RelocationType abs16 = R386_ABS16;
+        static constexpr RelocationType abs32 = R386_ABS32;
+        static constexpr RelocationType pc8 = R386_PC8;
+        static constexpr RelocationType pc16 = R386_PC16;
+        static constexpr RelocationType pc32 = R386_PC32;
+
+        static uint32_t relocationInfo(uint32_t symbol, RelocationType type) { return SetRelocationInfo32(symbol, type); }
+    };
+
+    struct ELF64
+    {
+        using Header = Header64;
+        using SectionHeader = SectionHeader64;
+        using SymbolEntry = Symbol::Entry64;
+        using RelEntry = RelEntry64;
+        using RelaEntry = RelaEntry64;
+        using Word = uint64_t;
+        using Addend = int64_t;
+        using RelocationType = RelocationType64;
+
+        static constexpr uint8_t bitness = Bitness::BITS64;
+        static constexpr InstructionSet x86 = InstructionSet::X64;
+        static constexpr InstructionSet arm = InstructionSet::ARM64;
+        static constexpr uint64_t tableAlignment = 8;
+        static constexpr bool alwaysAddend = true;
+
+        static constexpr bool relocations64 = true;
+        static constexpr RelocationType abs8 = RX64_ABS8;
+        static constexpr RelocationType abs16 = RX64_ABS16;
+        static constexpr RelocationType abs32 = RX64_ABS32;
+        static constexpr RelocationType abs64 = RX64_ABS64;
+        static constexpr RelocationType pc8 = RX64_PC8;
+        static constexpr RelocationType pc16 = RX64_PC16;
+        static constexpr RelocationType pc32 = RX64_PC32;
+        static constexpr RelocationType pc64 = RX64_PC64;
+
+        static uint64_t relocationInfo(uint32_t symbol, RelocationType type) { return SetRelocationInfo64(symbol, type); }
+    };
 }
\ No newline at end of file
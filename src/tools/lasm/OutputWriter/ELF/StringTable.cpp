@@ -0,0 +1,57 @@
+#include "StringTable.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+
+uint32_t ELF::StringTable::add(std::string_view name)
+{
+    auto it = handles.find(name);
+    if (it != handles.end()) return it->second;
+
+    const uint32_t handle = static_cast<uint32_t>(strings.size());
+    strings.emplace_back(name);
+    handles.emplace(strings.back(), handle);
+    return handle;
+}
+
+void ELF::StringTable::finalize()
+{
+    // sorted by their reversed bytes, a name comes right after the longer names that end with it
+    std::vector<uint32_t> order(strings.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b)
+    {
+        const std::string& lhs = strings[a];
+        const std::string& rhs = strings[b];
+        return std::lexicographical_compare(rhs.rbegin(), rhs.rend(), lhs.rbegin(), lhs.rend());
+    });
+
+    // offset 0 is the empty name, every table starts with a null byte
+    offsets.assign(strings.size(), 0);
+    std::vector<uint32_t> stored;
+    uint64_t size = 1;
+    for (uint32_t handle : order)
+    {
+        const std::string& name = strings[handle];
+        if (name.empty()) continue;
+
+        if (!stored.empty())
+        {
+            const std::string& previous = strings[stored.back()];
+            if (previous.size() >= name.size() && previous.compare(previous.size() - name.size(), name.size(), name) == 0)
+            {
+                offsets[handle] = offsets[stored.back()] + static_cast<uint32_t>(previous.size() - name.size());
+                continue;
+            }
+        }
+
+        offsets[handle] = static_cast<uint32_t>(size);
+        size += name.size() + 1;
+        stored.push_back(handle);
+    }
+
+    buffer.assign(size, 0);
+    for (uint32_t handle : stored)
+        std::memcpy(buffer.data() + offsets[handle], strings[handle].data(), strings[handle].size());
+}
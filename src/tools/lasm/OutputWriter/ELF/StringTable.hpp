@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <inttypes.h>
+
+namespace ELF
+{
+    // .strtab and .shstrtab contents. Names are added first and get a handle,
+    // offsets are only known after finalize, once duplicates and suffixes are merged.
+    class StringTable
+    {
+    public:
+        // handle 0 is the empty name, e.g. for section symbols
+        StringTable() { add(""); }
+
+        // the same name always gets the same handle
+        uint32_t add(std::string_view name);
+        void finalize();
+
+        uint32_t offset(uint32_t handle) const { return offsets[handle]; }
+        const std::vector<uint8_t>& data() const { return buffer; }
+
+    private:
+        std::deque<std::string> strings;    // deque, the views in handles stay valid
+        std::unordered_map<std::string_view, uint32_t> handles;
+        std::vector<uint32_t> offsets;
+        std::vector<uint8_t> buffer;
+    };
+}
@@ -2,6 +2,7 @@
 #include <limits>
 #include <memory>
 #include <cstring>
+#include <algorithm>
 
 Binary::Writer::Writer(const Context &_context, Architecture _arch, BitMode _bits, Format _format, std::ostream *_file, const Parser::Parser *_parser, const Encoder::Encoder *_encoder)
     : ::Output::Writer::Writer(_context, _arch, _bits, _format, _file, _parser, _encoder)
@@ -10,66 +11,69 @@ Binary::Writer::Writer(const Context &_context, Architecture _arch, BitMode _bit
 
 void Binary::Writer::Write()
 {
-    std::vector<Encoder::Section> sections = encoder->getSections();
+    const std::vector<Encoder::Section>& sections = encoder->getSections();
 
-    std::vector<Encoder::Section> uninitialized;
+    // uninitialized sections go after all the others
+    std::vector<size_t> order;
+    order.reserve(sections.size());
+    for (size_t i = 0; i < sections.size(); i++)
+    {
+        if (sections[i].align == 0)
+            throw Exception::InternalError("Alignment not set for section '" + sections[i].name + "'", -1, -1);
+        if (sections[i].isInitialized) order.push_back(i);
+    }
+    for (size_t i = 0; i < sections.size(); i++)
+        if (!sections[i].isInitialized) order.push_back(i);
 
-    std::unordered_map<std::string, uint64_t> sectionOffsets;
-    std::unordered_map<std::string, std::vector<uint8_t>*> sectionBuffers;
+    std::vector<uint64_t> sectionOffsets(sections.size());
 
     uint64_t off = 0;
-    for (Encoder::Section& section : sections)
+    for (size_t i : order)
     {
-        if (section.align == 0)
-            throw Exception::InternalError("Alignment not set for section '" + section.name + "'", -1, -1);
+        const Encoder::Section& section = sections[i];
 
         uint64_t align = section.align;
         if (align < 4) align = 4; // TODO: minimal alignment of 4, check if useful
 
         off = (off + align - 1) / align * align;
 
-        sectionBuffers[section.name] = &section.buffer;
-
-        if (!section.isInitialized)
-        {
-            uninitialized.push_back(section);
-            continue;
-        }
-        
-        sectionOffsets[section.name] = off;
+        sectionOffsets[i] = off;
 
         off += static_cast<uint64_t>(section.size());
     }
-    for (const Encoder::Section& section : uninitialized)
-    {
-        uint64_t align = section.align;
-        if (align < 4) align = 4; // TODO: minimal alignment of 4, check if useful
-
-        off = (off + align - 1) / align * align;
-
-        sectionOffsets[section.name] = off;
 
-        off += static_cast<uint64_t>(section.size());
-    }
+    // relocated fields are written from here instead of patching a copy of the section
+    struct Patch
+    {
+        uint64_t offset;
+        size_t order;       // position in the relocations of the section, later ones win
+        uint8_t size;
+        uint8_t bytes[8];
+    };
+    std::vector<std::vector<Patch>> patches(sections.size());
 
     for (const Encoder::Relocation& relocation : encoder->getRelocations())
     {
         if (relocation.isExtern) throw Exception::SemanticError("Can't use external labels with binary output", -1, -1);
 
-        auto itBuf = sectionBuffers.find(relocation.section);
-        if (itBuf == sectionBuffers.end()) throw Exception::InternalError("Section wasn't found", -1, -1);
-        std::vector<uint8_t>* sectionBuffer = itBuf->second;
-
-        auto it = sectionOffsets.find(relocation.usedSection);
-        if (it == sectionOffsets.end()) throw Exception::InternalError("Used section wasn't found", -1, -1);
-        const uint64_t& sectionOffset = it->second;
-        const int64_t value = sectionOffset + relocation.addend;
+        const size_t sectionIndex = relocation.sectionIndex;
+        if (sectionIndex >= sections.size()) throw Exception::InternalError("Section wasn't found", -1, -1);
+        if (relocation.usedSectionIndex >= sections.size()) throw Exception::InternalError("Used section wasn't found", -1, -1);
+        int64_t value = sectionOffsets[relocation.usedSectionIndex] + relocation.addend;
 
         const uint64_t& offset = relocation.offsetInSection;
+
+        if (relocation.type == Encoder::RelocationType::Relative)
+            value -= static_cast<int64_t>(sectionOffsets[sectionIndex] + offset);
+
+        Patch patch;
+        patch.offset = offset;
+        patch.order = patches[sectionIndex].size();
         
         switch (relocation.type)
         {
             case Encoder::RelocationType::Absolute:
+            case Encoder::RelocationType::Relative:
             {
                 switch (relocation.size)
                 {
@@ -80,7 +84,8 @@ void Binary::Writer::Write()
                             throw Exception::OverflowError("Relocation would overflow", -1, -1);
                         
                         const int8_t val = static_cast<int8_t>(value);
-                        std::memcpy(sectionBuffer->data() + offset, &val, sizeof(uint8_t));
+                        std::memcpy(patch.bytes, &val, sizeof(uint8_t));
+                        patch.size = sizeof(uint8_t);
                         break;
                     }
                     case Encoder::RelocationSize::Bit16:
@@ -90,7 +95,8 @@ void Binary::Writer::Write()
                             throw Exception::OverflowError("Relocation would overflow", -1, -1);
 
                         const int16_t val = static_cast<int16_t>(value);
-                        std::memcpy(sectionBuffer->data() + offset, &val, sizeof(uint16_t));
+                        std::memcpy(patch.bytes, &val, sizeof(uint16_t));
+                        patch.size = sizeof(uint16_t);
                         break;
                     }
                     case Encoder::RelocationSize::Bit24:
@@ -104,12 +110,10 @@ void Binary::Writer::Write()
                         int32_t val = static_cast<int32_t>(value);
 
                         // Little-endian
-                        uint8_t bytes[3];
-                        bytes[0] = static_cast<uint8_t>(val & 0xFF);
-                        bytes[1] = static_cast<uint8_t>((val >> 8) & 0xFF);
-                        bytes[2] = static_cast<uint8_t>((val >> 16) & 0xFF);
-
-                        std::memcpy(sectionBuffer->data() + offset, bytes, 3);
+                        patch.bytes[0] = static_cast<uint8_t>(val & 0xFF);
+                        patch.bytes[1] = static_cast<uint8_t>((val >> 8) & 0xFF);
+                        patch.bytes[2] = static_cast<uint8_t>((val >> 16) & 0xFF);
+                        patch.size = 3;
                         break;
                     }
                     case Encoder::RelocationSize::Bit32:
@@ -119,7 +123,8 @@ void Binary::Writer::Write()
                             throw Exception::OverflowError("Relocation would overflow (32-bit)", -1, -1);
 
                         const int32_t val = static_cast<int32_t>(value);
-                        std::memcpy(sectionBuffer->data() + offset, &val, sizeof(uint32_t));
+                        std::memcpy(patch.bytes, &val, sizeof(uint32_t));
+                        patch.size = sizeof(uint32_t);
                         break;
                     }
                     case Encoder::RelocationSize::Bit64:
@@ -129,7 +134,8 @@ void Binary::Writer::Write()
                             throw Exception::OverflowError("Relocation would overflow (64-bit)", -1, -1);
 
                         const int64_t val = static_cast<int64_t>(value);
-                        std::memcpy(sectionBuffer->data() + offset, &val, sizeof(uint64_t));
+                        std::memcpy(patch.bytes, &val, sizeof(uint64_t));
+                        patch.size = sizeof(uint64_t);
                         break;
                     }
                 }
@@ -138,38 +144,106 @@ void Binary::Writer::Write()
 
             default: throw Exception::InternalError("Unknown relocation type", -1, -1); break;
         }
+
+        patches[sectionIndex].push_back(patch);
     }
 
-    // TODO
-    for (const Encoder::Section& section : sections)
-    {
-        if (section.align == 0)
-            throw Exception::InternalError("Alignment not set for section '" + section.name + "'", -1, -1);
+    static const char zeros[4096] = {};
+    constexpr uint64_t blockSize = sizeof(zeros);
 
-        if (!section.isInitialized) continue;
+    // with sparse output, whole zero blocks are skipped and left as holes in the file
+    const bool sparse = context.sparseOutput && file->tellp() != std::streampos(-1);
+    uint64_t position = 0;
+    uint64_t hole = 0;      // skipped bytes that the file doesn't cover yet
 
-        std::streampos pos = file->tellp();
-        if (pos == -1)
-            throw Exception::IOError("Failed to get file position", -1, -1);
+    auto writeBytes = [&](const char* data, uint64_t size)
+    {
+        if (!sparse)
+        {
+            file->write(data, static_cast<std::streamsize>(size));
+            position += size;
+            return;
+        }
 
-        uint64_t offset = static_cast<uint64_t>(pos);
+        while (size > 0)
+        {
+            const uint64_t chunk = std::min(size, blockSize - position % blockSize);
+            if (chunk == blockSize && std::memcmp(data, zeros, blockSize) == 0)
+                hole += chunk;
+            else
+            {
+                if (hole)
+                {
+                    file->seekp(static_cast<std::streamoff>(hole), std::ios::cur);
+                    hole = 0;
+                }
+                file->write(data, static_cast<std::streamsize>(chunk));
+            }
+            data += chunk;
+            size -= chunk;
+            position += chunk;
+        }
+    };
+    auto writeZeros = [&](uint64_t size)
+    {
+        for (; size > blockSize; size -= blockSize)
+            writeBytes(zeros, blockSize);
+        writeBytes(zeros, size);
+    };
 
-        uint64_t align = section.align;
-        if (align < 4) align = 4; // TODO: minimal alignment of 4, check if useful
+    for (size_t i : order)
+    {
+        const Encoder::Section& section = sections[i];
+        if (!section.isInitialized) break;
 
-        uint64_t padding = (align - (offset % align)) % align;
+        writeZeros(sectionOffsets[i] - position);
 
-        if (padding > 0)
+        const char* data = reinterpret_cast<const char*>(section.buffer.data());
+        std::vector<Patch>& sectionPatches = patches[i];
+        std::stable_sort(sectionPatches.begin(), sectionPatches.end(), [](const Patch& a, const Patch& b) { return a.offset < b.offset; });
+
+        uint64_t done = 0;
+        for (size_t p = 0; p < sectionPatches.size();)
         {
-            std::vector<char> pad(padding, 0);
-            file->write(pad.data(), pad.size());
-        }
+            const Patch& first = sectionPatches[p];
+            writeBytes(data + done, first.offset - done);
+
+            // patches that overlap are written together
+            size_t last = p + 1;
+            uint64_t end = first.offset + first.size;
+            for (; last < sectionPatches.size() && sectionPatches[last].offset < end; last++)
+                end = std::max<uint64_t>(end, sectionPatches[last].offset + sectionPatches[last].size);
+
+            if (last == p + 1)
+                writeBytes(reinterpret_cast<const char*>(first.bytes), first.size);
+            else
+            {
+                // a byte covered by a later relocation is dropped from the earlier ones
+                for (uint64_t pos = first.offset; pos < end; pos++)
+                {
+                    const Patch* owner = nullptr;
+                    for (size_t q = p; q < last; q++)
+                    {
+                        const Patch& patch = sectionPatches[q];
+                        if (pos >= patch.offset && pos < patch.offset + patch.size && (!owner || patch.order > owner->order))
+                            owner = &patch;
+                    }
+                    writeBytes(owner ? reinterpret_cast<const char*>(owner->bytes + (pos - owner->offset)) : data + pos, 1);
+                }
+            }
 
-        file->write(reinterpret_cast<const char *>(section.buffer.data()), section.buffer.size());
+            done = end;
+            p = last;
+        }
+        writeBytes(data + done, section.buffer.size() - done);
     }
 
-    for (const Encoder::Section& section : uninitialized)
+    // a hole at the end only counts once something is written after it
+    if (hole)
     {
-        // TODO
+        file->seekp(static_cast<std::streamoff>(hole - 1), std::ios::cur);
+        file->put(0);
     }
-}
\ No newline at end of file
+
+    // uninitialized sections aren't part of the image
+}
@@ -0,0 +1,124 @@
+#include "Parser.hpp"
+
+static int precedence(char op)
+{
+    if (op == '+' || op == '-') return 1;
+    if (op == '*' || op == '/' || op == '%') return 2;
+    return 0;
+}
+
+static Parser::ExpressionToken::Operator toOperator(char op, size_t line, size_t column)
+{
+    using Operator = Parser::ExpressionToken::Operator;
+    switch (op)
+    {
+        case '+': return Operator::Add;
+        case '-': return Operator::Sub;
+        case '*': return Operator::Mul;
+        case '/': return Operator::Div;
+        case '%': return Operator::Mod;
+        default:
+            throw Exception::SyntaxError(std::string("Unexpected '") + op + "' in expression", line, column);
+    }
+}
+
+static Parser::ExpressionToken makeOperatorToken(char op, size_t line, size_t column)
+{
+    Parser::ExpressionToken token;
+    token.type = Parser::ExpressionToken::Type::Operator;
+    token.op = toOperator(op, line, column);
+    token.negative = false;
+    token.value = 0;
+    return token;
+}
+
+// shunting yard, operators are all left associative
+Parser::Immediate Parser::Parser::makeImmediate(const std::vector<ImmediateOperand>& operands, size_t line, size_t column)
+{
+    std::vector<ExpressionToken> output;
+    std::vector<char> operatorStack;
+    output.reserve(operands.size());
+
+    bool expectUnaryMinus = false;
+
+    for (size_t i = 0; i < operands.size(); i++)
+    {
+        const auto& operand = operands[i];
+
+        if (std::holds_alternative<Operator>(operand))
+        {
+            char op = std::get<Operator>(operand).op;
+
+            if (op == '-' && (
+                i == 0 ||
+                (std::holds_alternative<Operator>(operands[i - 1]) && std::get<Operator>(operands[i - 1]).op != ')')
+            ))
+            {
+                expectUnaryMinus = true;
+            }
+            else if (op == '(')
+            {
+                operatorStack.push_back(op);
+            }
+            else if (op == ')')
+            {
+                while (!operatorStack.empty() && operatorStack.back() != '(')
+                {
+                    output.push_back(makeOperatorToken(operatorStack.back(), line, column));
+                    operatorStack.pop_back();
+                }
+                if (operatorStack.empty())
+                    throw Exception::SyntaxError("Mismatched parentheses", line, column);
+                operatorStack.pop_back();
+            }
+            else
+            {
+                // validate before it ends up on the stack
+                toOperator(op, line, column);
+
+                while (!operatorStack.empty() && operatorStack.back() != '(' && precedence(op) <= precedence(operatorStack.back()))
+                {
+                    output.push_back(makeOperatorToken(operatorStack.back(), line, column));
+                    operatorStack.pop_back();
+                }
+                operatorStack.push_back(op);
+            }
+            continue;
+        }
+
+        ExpressionToken token;
+        token.op = ExpressionToken::Operator::Add;
+        token.negative = expectUnaryMinus;
+        expectUnaryMinus = false;
+
+        if (std::holds_alternative<Integer>(operand))
+        {
+            token.type = ExpressionToken::Type::Integer;
+            token.value = std::get<Integer>(operand).value;
+        }
+        else if (std::holds_alternative<String>(operand))
+        {
+            token.type = ExpressionToken::Type::String;
+            token.value = std::get<String>(operand).value;
+        }
+        else
+        {
+            token.type = std::get<CurrentPosition>(operand).sectionPos ? ExpressionToken::Type::SectionPosition : ExpressionToken::Type::Position;
+            token.value = 0;
+        }
+        output.push_back(token);
+    }
+
+    while (!operatorStack.empty())
+    {
+        if (operatorStack.back() == '(')
+            throw Exception::SyntaxError("Mismatched parentheses", line, column);
+        output.push_back(makeOperatorToken(operatorStack.back(), line, column));
+        operatorStack.pop_back();
+    }
+
+    Immediate immediate;
+    immediate.operands = arena.copy(operands);
+    immediate.rpn = arena.copy(output);
+    return immediate;
+}
@@ -63,7 +63,7 @@ void Parser::Parser::Print() const
                             else if (std::holds_alternative<String>(op))
                             {
                                 const String& str = std::get<String>(op);
-                                std::cout << "'" << str.value << "'" << std::endl;
+                                std::cout << "'" << context.stringPool->lookup(str.value) << "'" << std::endl;
                             }
                             else if (std::holds_alternative<CurrentPosition>(op))
                             {
@@ -111,7 +111,7 @@ void Parser::Parser::Print() const
                         else if (std::holds_alternative<String>(op))
                         {
                             const String& str = std::get<String>(op);
-                            std::cout << "'" << str.value << "'" << std::endl;;
+                            std::cout << "'" << context.stringPool->lookup(str.value) << "'" << std::endl;;
                         }
                         else if (std::holds_alternative<CurrentPosition>(op))
                         {
@@ -134,16 +134,16 @@ void Parser::Parser::Print() const
                     std::cout << "Extern label '";
                 else
                     std::cout << "Local label '";
-                std::cout << label.name << "' on line " << label.lineNumber << " in column " << label.column << std::endl;
+                std::cout << context.stringPool->lookup(label.name) << "' on line " << label.lineNumber << " in column " << label.column << std::endl;
             }
             else if (std::holds_alternative<Constant>(entry))
             {
                 const Constant& constant = std::get<Constant>(entry);
                 std::cout << "  ";  // '  '
                 if (constant.isGlobal)
-                    std::cout << "Global constant '" << constant.name << "' ";
+                    std::cout << "Global constant '" << context.stringPool->lookup(constant.name) << "' ";
                 else
-                    std::cout << "Constant '" << constant.name << "' ";
+                    std::cout << "Constant '" << context.stringPool->lookup(constant.name) << "' ";
 
                 if (constant.hasPos)
                     std::cout << "with current position";
@@ -166,7 +166,7 @@ void Parser::Parser::Print() const
                     else if (std::holds_alternative<String>(op))
                     {
                         const String& str = std::get<String>(op);
-                        std::cout << "'" << str.value << "'" << std::endl;;
+                        std::cout << "'" << context.stringPool->lookup(str.value) << "'" << std::endl;;
                     }
                     else if (std::holds_alternative<CurrentPosition>(op))
                     {
@@ -200,7 +200,7 @@ void Parser::Parser::Print() const
                     else if (std::holds_alternative<String>(op))
                     {
                         const String& str = std::get<String>(op);
-                        std::cout << "'" << str.value << "'" << std::endl;;
+                        std::cout << "'" << context.stringPool->lookup(str.value) << "'" << std::endl;;
                     }
                     else if (std::holds_alternative<CurrentPosition>(op))
                     {
@@ -234,7 +234,7 @@ void Parser::Parser::Print() const
                     else if (std::holds_alternative<String>(op))
                     {
                         const String& str = std::get<String>(op);
-                        std::cout << "'" << str.value << "'" << std::endl;;
+                        std::cout << "'" << context.stringPool->lookup(str.value) << "'" << std::endl;;
                     }
                     else if (std::holds_alternative<CurrentPosition>(op))
                     {
@@ -6,6 +6,8 @@
 #include <unordered_map>
 #include <Architecture.hpp>
 #include <vector>
+#include <type_traits>
+#include <util/Arena.hpp>
 #include "../Context.hpp"
 #include "Tokenizer.hpp"
 
@@ -18,12 +20,13 @@ namespace Parser
 
     struct Operator
     {
-        std::string op;
+        char op;
     };
 
+    // symbol name, interned in the string pool
     struct String
     {
-        std::string value;
+        uint32_t value;
     };
 
     struct CurrentPosition
@@ -33,9 +36,22 @@ namespace Parser
 
     using ImmediateOperand = std::variant<Integer, Operator, String, CurrentPosition>;
 
+    // one step of an immediate in reverse polish notation
+    struct ExpressionToken
+    {
+        enum class Type : uint8_t { Integer, String, Position, SectionPosition, Operator };
+        enum class Operator : uint8_t { Add, Sub, Mul, Div, Mod };
+
+        Type type;
+        Operator op;
+        bool negative;      // unary minus on a value
+        uint64_t value;     // integer or interned symbol name
+    };
+
     struct Immediate
     {
-        std::vector<ImmediateOperand> operands;
+        Span<ImmediateOperand> operands;
+        Span<ExpressionToken> rpn;  // compiled once by the parser
     };
 
     namespace Instruction
@@ -55,7 +71,7 @@ namespace Parser
         struct Instruction
         {
             uint64_t mnemonic;
-            std::vector<Operand> operands;
+            Span<Operand> operands;
             BitMode bits;
 
             size_t lineNumber;
@@ -70,7 +86,7 @@ namespace Parser
     {
         size_t size;
         bool reserved;
-        std::vector<Immediate> values;
+        Span<Immediate> values;
 
         size_t lineNumber;
         size_t column;
@@ -78,7 +94,7 @@ namespace Parser
 
     struct Label
     {
-        std::string name;
+        uint32_t name;
         bool isGlobal;
         bool isExtern;
 
@@ -88,7 +104,7 @@ namespace Parser
 
     struct Constant
     {
-        std::string name;
+        uint32_t name;
         Immediate value;
         bool isGlobal;
 
@@ -109,6 +125,8 @@ namespace Parser
     struct Alignment
     {
         Immediate align;
+        // mode at the align, picks the padding NOPs
+        BitMode bits;
 
         size_t lineNumber;
         size_t column;
@@ -124,25 +142,34 @@ namespace Parser
         uint64_t align = 0;
     };
 
+    // entries point into the parser's arena and are never destroyed individually
+    static_assert(std::is_trivially_destructible_v<SectionEntry>);
+
     class Parser
     {
     public:
         Parser(const Context& _context, Architecture _arch, BitMode _bits);
         virtual ~Parser() = default;
 
-        virtual void Parse(const std::vector<Token::Token>& tokens) = 0;
+        virtual void Parse(Token::TokenStream&& tokens) = 0;
         void Print() const;
 
         const std::string& getOrg() const noexcept { return org; }
         const std::vector<Section>& getSections() const noexcept { return sections; }
 
     protected:
+        // copies the operands into the arena and compiles them to rpn
+        Immediate makeImmediate(const std::vector<ImmediateOperand>& operands, size_t line, size_t column);
+
         Context context;
         Architecture arch;
         BitMode bits;
 
         std::string org;
         std::vector<Section> sections;
+
+        // owns everything the section entries point to
+        Arena arena;
     };
 
     Parser* getParser(const Context& context, Architecture arch, BitMode bits);
@@ -0,0 +1,204 @@
+#include "Scanner.hpp"
+
+#include <algorithm>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define LASM_SCANNER_X86 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    using Skip = size_t (*)(const char*, size_t, size_t);
+
+    // most runs are only a few bytes long, so they're checked byte by byte before using vectors
+    constexpr size_t shortRun = 8;
+
+    size_t skipWhitespaceScalar(const char* data, size_t pos, size_t length)
+    {
+        while (pos < length && Token::Scanner::isSpace(data[pos]))
+            pos++;
+        return pos;
+    }
+
+    size_t skipIdentifierScalar(const char* data, size_t pos, size_t length)
+    {
+        while (pos < length && !Token::Scanner::isDelimiter(data[pos]))
+            pos++;
+        return pos;
+    }
+
+#ifdef LASM_SCANNER_X86
+    // ' ' or '\t'..'\r'
+    __attribute__((target("sse2")))
+    inline __m128i spaceMask128(__m128i c)
+    {
+        const __m128i shifted = _mm_sub_epi8(c, _mm_set1_epi8('\t'));
+        const __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8('\r' - '\t')), shifted);
+        return _mm_or_si128(control, _mm_cmpeq_epi8(c, _mm_set1_epi8(' ')));
+    }
+
+    // "'(),:;[]{}+-*/% and whitespace
+    __attribute__((target("sse2")))
+    inline __m128i delimiterMask128(__m128i c)
+    {
+        __m128i a = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(',')), _mm_cmpeq_epi8(c, _mm_set1_epi8(';')));
+        __m128i b = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(':')), _mm_cmpeq_epi8(c, _mm_set1_epi8('"')));
+        a = _mm_or_si128(a, _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('(')), _mm_cmpeq_epi8(c, _mm_set1_epi8(')'))));
+        b = _mm_or_si128(b, _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('[')), _mm_cmpeq_epi8(c, _mm_set1_epi8(']'))));
+        a = _mm_or_si128(a, _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('{')), _mm_cmpeq_epi8(c, _mm_set1_epi8('}'))));
+        b = _mm_or_si128(b, _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('\'')), _mm_cmpeq_epi8(c, _mm_set1_epi8('+'))));
+        a = _mm_or_si128(a, _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('-')), _mm_cmpeq_epi8(c, _mm_set1_epi8('*'))));
+        b = _mm_or_si128(b, _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('/')), _mm_cmpeq_epi8(c, _mm_set1_epi8('%'))));
+        return _mm_or_si128(spaceMask128(c), _mm_or_si128(a, b));
+    }
+
+    __attribute__((target("sse2")))
+    size_t skipWhitespaceSSE2(const char* data, size_t pos, size_t length)
+    {
+        const size_t shortEnd = std::min(length, pos + shortRun);
+        pos = skipWhitespaceScalar(data, pos, shortEnd);
+        if (pos < shortEnd)
+            return pos;
+
+        while (pos + 16 <= length)
+        {
+            const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+            const unsigned int stop = ~static_cast<unsigned int>(_mm_movemask_epi8(spaceMask128(c))) & 0xFFFFu;
+            if (stop)
+                return pos + __builtin_ctz(stop);
+            pos += 16;
+        }
+        return skipWhitespaceScalar(data, pos, length);
+    }
+
+    __attribute__((target("sse2")))
+    size_t skipIdentifierSSE2(const char* data, size_t pos, size_t length)
+    {
+        const size_t shortEnd = std::min(length, pos + shortRun);
+        pos = skipIdentifierScalar(data, pos, shortEnd);
+        if (pos < shortEnd)
+            return pos;
+
+        while (pos + 16 <= length)
+        {
+            const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+            const unsigned int stop = static_cast<unsigned int>(_mm_movemask_epi8(delimiterMask128(c)));
+            if (stop)
+                return pos + __builtin_ctz(stop);
+            pos += 16;
+        }
+        return skipIdentifierScalar(data, pos, length);
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256i spaceMask256(__m256i c)
+    {
+        const __m256i shifted = _mm256_sub_epi8(c, _mm256_set1_epi8('\t'));
+        const __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8('\r' - '\t')), shifted);
+        return _mm256_or_si256(control, _mm256_cmpeq_epi8(c, _mm256_set1_epi8(' ')));
+    }
+
+    // delimiters are looked up by their low nibble, characters sharing a nibble are in separate tables.
+    // unused entries can't match: 0xFF only in slot 0 and 0x80 elsewhere have the wrong low nibble
+    __attribute__((target("avx2")))
+    inline __m256i delimiterMask256(__m256i c)
+    {
+        constexpr char Z = static_cast<char>(0xFF);
+        constexpr char X = static_cast<char>(0x80);
+
+        const __m256i low = _mm256_and_si256(c, _mm256_set1_epi8(0x0F));
+        const __m256i table1 = _mm256_setr_epi8(
+            Z, X, '"', X, X, '%', X, '\'', '(', ')', '*', '+', ',', '-', X, '/',
+            Z, X, '"', X, X, '%', X, '\'', '(', ')', '*', '+', ',', '-', X, '/');
+        const __m256i table2 = _mm256_setr_epi8(
+            Z, X, X, X, X, X, X, X, X, X, ':', ';', X, X, X, X,
+            Z, X, X, X, X, X, X, X, X, X, ':', ';', X, X, X, X);
+        const __m256i table3 = _mm256_setr_epi8(
+            Z, X, X, X, X, X, X, X, X, X, X, '[', X, ']', X, X,
+            Z, X, X, X, X, X, X, X, X, X, X, '[', X, ']', X, X);
+        const __m256i table4 = _mm256_setr_epi8(
+            Z, X, X, X, X, X, X, X, X, X, X, '{', X, '}', X, X,
+            Z, X, X, X, X, X, X, X, X, X, X, '{', X, '}', X, X);
+
+        __m256i mask = _mm256_cmpeq_epi8(_mm256_shuffle_epi8(table1, low), c);
+        mask = _mm256_or_si256(mask, _mm256_cmpeq_epi8(_mm256_shuffle_epi8(table2, low), c));
+        mask = _mm256_or_si256(mask, _mm256_cmpeq_epi8(_mm256_shuffle_epi8(table3, low), c));
+        mask = _mm256_or_si256(mask, _mm256_cmpeq_epi8(_mm256_shuffle_epi8(table4, low), c));
+        return _mm256_or_si256(mask, spaceMask256(c));
+    }
+
+    __attribute__((target("avx2")))
+    size_t skipWhitespaceAVX2(const char* data, size_t pos, size_t length)
+    {
+        const size_t shortEnd = std::min(length, pos + shortRun);
+        pos = skipWhitespaceScalar(data, pos, shortEnd);
+        if (pos < shortEnd)
+            return pos;
+
+        while (pos + 32 <= length)
+        {
+            const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+            const unsigned int stop = ~static_cast<unsigned int>(_mm256_movemask_epi8(spaceMask256(c)));
+            if (stop)
+                return pos + __builtin_ctz(stop);
+            pos += 32;
+        }
+        return skipWhitespaceScalar(data, pos, length);
+    }
+
+    __attribute__((target("avx2")))
+    size_t skipIdentifierAVX2(const char* data, size_t pos, size_t length)
+    {
+        const size_t shortEnd = std::min(length, pos + shortRun);
+        pos = skipIdentifierScalar(data, pos, shortEnd);
+        if (pos < shortEnd)
+            return pos;
+
+        while (pos + 32 <= length)
+        {
+            const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+            const unsigned int stop = static_cast<unsigned int>(_mm256_movemask_epi8(delimiterMask256(c)));
+            if (stop)
+                return pos + __builtin_ctz(stop);
+            pos += 32;
+        }
+        return skipIdentifierScalar(data, pos, length);
+    }
+#endif
+
+    struct Dispatch
+    {
+        Skip whitespace = skipWhitespaceScalar;
+        Skip identifier = skipIdentifierScalar;
+
+        Dispatch()
+        {
+#ifdef LASM_SCANNER_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2"))
+            {
+                whitespace = skipWhitespaceAVX2;
+                identifier = skipIdentifierAVX2;
+            }
+            else if (__builtin_cpu_supports("sse2"))
+            {
+                whitespace = skipWhitespaceSSE2;
+                identifier = skipIdentifierSSE2;
+            }
+#endif
+        }
+    };
+
+    const Dispatch dispatch;
+}
+
+size_t Token::Scanner::skipWhitespace(const char* data, size_t pos, size_t length)
+{
+    return dispatch.whitespace(data, pos, length);
+}
+
+size_t Token::Scanner::skipIdentifier(const char* data, size_t pos, size_t length)
+{
+    return dispatch.identifier(data, pos, length);
+}
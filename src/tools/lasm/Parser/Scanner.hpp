@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Token
+{
+    namespace Scanner
+    {
+        enum CharClass : uint8_t
+        {
+            Space = 1 << 0,     // same set as std::isspace in the "C" locale
+            Delimiter = 1 << 1  // characters that end an identifier/number
+        };
+
+        constexpr std::array<uint8_t, 256> makeCharClasses()
+        {
+            std::array<uint8_t, 256> classes{};
+            for (unsigned char c : {' ', '\t', '\n', '\v', '\f', '\r'})
+                classes[c] = Space | Delimiter;
+            for (unsigned char c : {',', ';', ':', '(', ')', '[', ']', '{', '}', '"', '\'', '+', '-', '*', '/', '%'})
+                classes[c] = Delimiter;
+            return classes;
+        }
+
+        inline constexpr std::array<uint8_t, 256> charClasses = makeCharClasses();
+
+        inline bool isSpace(char c) noexcept
+        {
+            return (charClasses[static_cast<unsigned char>(c)] & Space) != 0;
+        }
+
+        inline bool isDelimiter(char c) noexcept
+        {
+            return (charClasses[static_cast<unsigned char>(c)] & Delimiter) != 0;
+        }
+
+        // first position >= pos that isn't whitespace (or length)
+        size_t skipWhitespace(const char* data, size_t pos, size_t length);
+
+        // first position >= pos that is whitespace or a delimiter (or length)
+        size_t skipIdentifier(const char* data, size_t pos, size_t length);
+    }
+}
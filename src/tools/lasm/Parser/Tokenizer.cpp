@@ -1,11 +1,12 @@
 #include "Tokenizer.hpp"
+#include "Scanner.hpp"
 
 #include <Exception.hpp>
 #include <util/string.hpp>
 #include <cstdint>
 
 Token::Tokenizer::Tokenizer(const Context& _context)
-    : context(&_context)
+    : context(&_context), tokens(_context.stringPool)
 {
 	
 }
@@ -14,22 +15,43 @@ void Token::Tokenizer::clear() {
     tokens.clear();
 }
 
-void Token::Tokenizer::tokenize(std::istream* input)
+namespace
 {
-    uint64_t file;
-    std::string line;
+    bool startsWithLineDirective(std::string_view line)
+    {
+        size_t start = Token::Scanner::skipWhitespace(line.data(), 0, line.size());
+        return line.compare(start, 5, "%line") == 0;
+    }
+}
+
+void Token::Tokenizer::tokenize(std::unique_ptr<InputBuffer> input)
+{
+    const std::string_view source = input->view();
+
+    uint64_t file = context->stringPool->intern(context->filename);
     size_t lineNumber = 0;
     size_t lineIncrease = 1;
 
-    while (std::getline(*input, line))
+    size_t lineStart = 0;
+    while (lineStart < source.size())
     {
+        size_t lineEnd = source.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos)
+            lineEnd = source.size();
+
+        const std::string_view line = source.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+
+        // reading at the end of the line yields '\0', like std::string does
+        auto at = [&line](size_t i) -> char { return i < line.size() ? line[i] : '\0'; };
+
         lineNumber += lineIncrease;
         size_t pos = 0;
         size_t length = line.size();
-        std::string trimmed = trim(line);
 
-        if (trimmed.find("%line") == 0)
+        if (startsWithLineDirective(line))
         {
+            std::string trimmed = trim(std::string(line));
             std::string rest = trim(trimmed.substr(5));
             size_t plusPos = rest.find('+');
             size_t spacePos = rest.find(' ');
@@ -55,8 +77,7 @@ void Token::Tokenizer::tokenize(std::istream* input)
         while (pos < length)
         {
             // Skip whitespace
-            while (pos < length && std::isspace(static_cast<unsigned char>(line[pos])))
-                pos++;
+            pos = Scanner::skipWhitespace(line.data(), pos, length);
             if (pos >= length) break;
 
             size_t startPos = pos;
@@ -64,7 +85,7 @@ void Token::Tokenizer::tokenize(std::istream* input)
             // ,
             if (line[pos] == ',')
             {
-                tokens.emplace_back(
+                tokens.push_back(
                     Type::Comma,
                     ",",
                     lineNumber,
@@ -73,17 +94,23 @@ void Token::Tokenizer::tokenize(std::istream* input)
                 );
                 pos++;
             }
-            // ; or :
-            else if (line[pos] == ';' || line[pos] == ':')
+            // ; (rest of the line is a comment and is only seen by the parser as ';')
+            else if (line[pos] == ';')
             {
-                tokens.emplace_back(Type::Punctuation, std::string() + line[pos], lineNumber, pos, file);
+                tokens.push_back(Type::Punctuation, line.substr(pos, 1), lineNumber, pos, file);
+                pos = length;
+            }
+            // :
+            else if (line[pos] == ':')
+            {
+                tokens.push_back(Type::Punctuation, line.substr(pos, 1), lineNumber, pos, file);
                 pos++;
             }
 
             // +,-,*,/
             else if (line[pos] == '+' || line[pos] == '-' || line[pos] == '*' || line[pos] == '/' || line[pos] == '%')
             {
-                tokens.emplace_back(Type::Operator, std::string() + line[pos], lineNumber, pos, file);
+                tokens.push_back(Type::Operator, line.substr(pos, 1), lineNumber, pos, file);
                 pos++;
             }
 
@@ -92,9 +119,9 @@ void Token::Tokenizer::tokenize(std::istream* input)
                      line[pos] == '[' || line[pos] == ']' ||
                      line[pos] == '{' || line[pos] == '}')
             {
-                tokens.emplace_back(
+                tokens.push_back(
                     Type::Bracket,
-                    std::string(1, line[pos]),
+                    line.substr(pos, 1),
                     lineNumber,
                     pos + 1,
                     file
@@ -107,13 +134,19 @@ void Token::Tokenizer::tokenize(std::istream* input)
             {
                 pos++;  // skip opening "
                 startPos = pos;
+                bool escaped = false;
                 std::string value;
                 while (pos < length)
                 {
                     if (line[pos] == '\\')
                     {
+                        if (!escaped)
+                        {
+                            value.assign(line.substr(startPos, pos - startPos));
+                            escaped = true;
+                        }
                         pos++;
-                        switch(line[pos])
+                        switch(at(pos))
                         {
                             case '\\': value.push_back('\\'); pos++; break;
                             case '"': value.push_back('"'); pos++; break;
@@ -130,12 +163,14 @@ void Token::Tokenizer::tokenize(std::istream* input)
                     }
                     else
                     {
-                        value.push_back(line[pos]);
+                        if (escaped)
+                            value.push_back(line[pos]);
                         pos++;
                     }
                 }
 
-                tokens.emplace_back(Type::String, value, lineNumber, startPos, file);
+                std::string_view str = escaped ? std::string_view(value) : line.substr(startPos, pos - startPos);
+                tokens.push_back(Type::String, str, lineNumber, startPos, file);
 
                 if (pos < length && line[pos] == '"')
                     pos++; // skip closing "
@@ -146,7 +181,7 @@ void Token::Tokenizer::tokenize(std::istream* input)
                 pos++;  // skip opening '
                 startPos = pos;
                 char value;
-                if (line[pos] == '\\')
+                if (at(pos) == '\\')
                 {
                     pos++;
                     if (pos >= line.length())
@@ -166,7 +201,7 @@ void Token::Tokenizer::tokenize(std::istream* input)
                 }
                 else
                 {
-                    value = line[pos];
+                    value = at(pos);
                 }
 
                 pos++;
@@ -176,7 +211,7 @@ void Token::Tokenizer::tokenize(std::istream* input)
                     throw Exception::SyntaxError("Expected closing '", lineNumber, pos);
                 }
 
-                tokens.emplace_back(Type::Character, std::string() + value, lineNumber, startPos, file);
+                tokens.push_back(Type::Character, std::string_view(&value, 1), lineNumber, startPos, file);
 
                 pos++; // skip closing '
             }
@@ -184,16 +219,9 @@ void Token::Tokenizer::tokenize(std::istream* input)
             // Everything else
             else
             {
-                while (pos < length &&
-                       !std::isspace(static_cast<unsigned char>(line[pos])) &&
-                       line[pos] != ',' && line[pos] != ';' && line[pos] != ':' &&
-                       line[pos] != '(' && line[pos] != ')' && line[pos] != '[' &&
-                       line[pos] != ']' && line[pos] != '{' && line[pos] != '}' &&
-                       line[pos] != '"' && line[pos] != '\'' &&
-                       line[pos] != '+' && line[pos] != '-' && line[pos] != '*' && line[pos] != '/' && line[pos] != '%')
-                    pos++;
-                
-                tokens.emplace_back(
+                pos = Scanner::skipIdentifier(line.data(), pos, length);
+
+                tokens.push_back(
                     Type::Token,
                     line.substr(startPos, pos - startPos),
                     lineNumber,
@@ -203,7 +231,7 @@ void Token::Tokenizer::tokenize(std::istream* input)
             }
         }
 
-        tokens.emplace_back(
+        tokens.push_back(
             Type::EOL,
             "",
             lineNumber,
@@ -211,7 +239,7 @@ void Token::Tokenizer::tokenize(std::istream* input)
             file
         );
     }
-    tokens.emplace_back(
+    tokens.push_back(
         Type::_EOF,
         "",
         lineNumber + 1,
@@ -220,9 +248,19 @@ void Token::Tokenizer::tokenize(std::istream* input)
     );
 }
 
-std::vector<Token::Token> Token::Tokenizer::getTokens()
+void Token::Tokenizer::append(TokenStream&& stream)
 {
-    return tokens;
+    if (tokens.empty())
+        tokens = std::move(stream);
+    else
+        tokens.append(stream);
+}
+
+Token::TokenStream Token::Tokenizer::takeTokens()
+{
+    TokenStream result = std::move(tokens);
+    tokens = TokenStream(context->stringPool);
+    return result;
 }
 
 void Token::Tokenizer::print()
@@ -230,7 +268,7 @@ void Token::Tokenizer::print()
     std::cout << "Tokens: " << std::endl;
     for (size_t i = 0; i < tokens.size(); i++)
     {
-        const Token& token = tokens[i];
+        const Token token = tokens[i];
         std::cout << "  " << token.what(context) << std::endl;
     }
 }
@@ -259,7 +297,7 @@ std::string Token::Token::what(const Context* context) const
         case Type::Bracket:
         case Type::Punctuation:
         default:
-            result += " '" + value + "' ";
+            result += " '" + std::string(value) + "' ";
             break;
     }
 
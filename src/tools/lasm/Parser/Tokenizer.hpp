@@ -3,14 +3,17 @@
 #include "../Context.hpp"
 #include <fstream>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <memory>
 #include <iostream>
 #include <StringPool.hpp>
+#include <io/file.hpp>
 #include <cstdint>
 
 namespace Token
 {
-    enum class Type
+    enum class Type : uint8_t
     {
         Token,
         String,
@@ -42,31 +45,122 @@ namespace Token
         }
     }
 
+    // Lightweight view of one token in a TokenStream
     struct Token
     {
         Type type;
-        std::string value;
-        size_t line;
-        size_t column;
-        uint64_t file;
-
-        Token(Type t, std::string v, size_t l, size_t c, uint64_t f)
-            : type(t), value(std::move(v)), line(l), column(c), file(f) {}
+        uint32_t lexeme;
+        std::string_view value;
+        uint32_t line;
+        uint32_t column;
+        uint32_t file;
 
         std::string what(const Context* context) const;
     };
 
+    // Tokens stored as struct of arrays, lexemes are interned in the string pool
+    class TokenStream
+    {
+    public:
+        explicit TokenStream(StringPool* _stringPool)
+            : stringPool(_stringPool) {}
+
+        void push_back(Type type, std::string_view value, size_t line, size_t column, uint64_t file)
+        {
+            types.push_back(type);
+            lexemes.push_back(static_cast<uint32_t>(stringPool->intern(value)));
+            lines.push_back(static_cast<uint32_t>(line));
+            columns.push_back(static_cast<uint32_t>(column));
+            files.push_back(static_cast<uint32_t>(file));
+        }
+
+        void push_back(const Token& token)
+        {
+            types.push_back(token.type);
+            lexemes.push_back(token.lexeme);
+            lines.push_back(token.line);
+            columns.push_back(token.column);
+            files.push_back(token.file);
+        }
+
+        // both streams have to share the string pool
+        void append(const TokenStream& other)
+        {
+            types.insert(types.end(), other.types.begin(), other.types.end());
+            lexemes.insert(lexemes.end(), other.lexemes.begin(), other.lexemes.end());
+            lines.insert(lines.end(), other.lines.begin(), other.lines.end());
+            columns.insert(columns.end(), other.columns.begin(), other.columns.end());
+            files.insert(files.end(), other.files.begin(), other.files.end());
+        }
+
+        // used for in-place filtering, from >= to
+        void move(size_t from, size_t to)
+        {
+            types[to] = types[from];
+            lexemes[to] = lexemes[from];
+            lines[to] = lines[from];
+            columns[to] = columns[from];
+            files[to] = files[from];
+        }
+
+        void setType(size_t index, Type type) noexcept
+        {
+            types[index] = type;
+        }
+
+        void truncate(size_t newSize)
+        {
+            types.resize(newSize);
+            lexemes.resize(newSize);
+            lines.resize(newSize);
+            columns.resize(newSize);
+            files.resize(newSize);
+        }
+
+        Token operator[](size_t index) const
+        {
+            return Token{types[index], lexemes[index], stringPool->lookup(lexemes[index]), lines[index], columns[index], files[index]};
+        }
+
+        Token back() const { return (*this)[size() - 1]; }
+
+        Type type(size_t index) const noexcept { return types[index]; }
+        size_t size() const noexcept { return types.size(); }
+        bool empty() const noexcept { return types.empty(); }
+
+        void clear()
+        {
+            types.clear();
+            lexemes.clear();
+            lines.clear();
+            columns.clear();
+            files.clear();
+        }
+
+    private:
+        StringPool* stringPool;
+
+        std::vector<Type> types;
+        std::vector<uint32_t> lexemes;
+        std::vector<uint32_t> lines;
+        std::vector<uint32_t> columns;
+        std::vector<uint32_t> files;
+    };
+
     class Tokenizer
     {
     public:
         Tokenizer(const Context& _context);
 
         void clear();
-        void tokenize(std::istream* input);
-        std::vector<Token> getTokens();
+        void tokenize(std::unique_ptr<InputBuffer> input);
+        // adds tokens from another tokenizer, e.g. one that ran on a worker thread
+        void append(TokenStream&& stream);
+        // moves the tokens out, the tokenizer is empty afterwards
+        TokenStream takeTokens();
         void print();
     private:
         const Context* context;
-        std::vector<Token> tokens;
+        TokenStream tokens;
     };
 }
@@ -1,6 +1,7 @@
 #include "Parser.hpp"
 
 #include <util/string.hpp>
+#include <util/KeywordTable.hpp>
 #include <unordered_set>
 #include <array>
 #include <algorithm>
@@ -19,14 +20,14 @@ Parser::ImmediateOperand getOperand(const Token::Token& token)
     if (token.type == Token::Type::Operator || token.type == Token::Type::Bracket)
     {
         Parser::Operator op;
-        op.op = token.value;
+        op.op = token.value[0];
         return op;
     }
-    else if (std::isdigit(static_cast<unsigned char>(token.value[0])) != 0)
+    else if (!token.value.empty() && std::isdigit(static_cast<unsigned char>(token.value[0])) != 0)
     {
         Parser::Integer integer;
         // TODO: currently only integer
-        integer.value = evalInteger(token.value, 8, token.line, token.column);
+        integer.value = evalInteger(std::string(token.value), 8, token.line, token.column);
         return integer;
     }
     else if (token.type == Token::Type::Character)
@@ -44,121 +45,184 @@ Parser::ImmediateOperand getOperand(const Token::Token& token)
     else
     {
         Parser::String str;
-        str.value = token.value;
+        str.value = token.lexeme;
         return str;
     }
 }
 
-void x86::Parser::Parse(const std::vector<Token::Token>& tokens)
+void x86::Parser::Parse(Token::TokenStream&& tokens)
 {
-    std::vector<Token::Token> filteredTokens;
+    // filter in place: drop comments and repeated EOLs
+    Token::TokenStream& filteredTokens = tokens;
+    size_t kept = 0;
     Token::Type before = Token::Type::_EOF;
     for (size_t i = 0; i < tokens.size(); i++)
     {
-        const Token::Token& token = tokens[i];
+        const Token::Type type = tokens.type(i);
 
-        if (token.type == Token::Type::EOL && before == Token::Type::EOL)
+        if (type == Token::Type::EOL && before == Token::Type::EOL)
             continue;
         
-        if (token.type == Token::Type::Punctuation && token.value.at(0) == ';')
+        if (type == Token::Type::Punctuation && tokens[i].value.at(0) == ';')
         {
-            while (i < tokens.size() && tokens[i].type != Token::Type::EOL && tokens[i].type != Token::Type::_EOF)
+            while (i < tokens.size() && tokens.type(i) != Token::Type::EOL && tokens.type(i) != Token::Type::_EOF)
                 i++;
             if (i < tokens.size())
-                filteredTokens.push_back(tokens[i]);
+                tokens.move(i, kept++);
             continue;
         }
 
-        before = token.type;
-        filteredTokens.push_back(token);
+        before = type;
+        tokens.move(i, kept++);
     }
+    filteredTokens.truncate(kept);
 
-    std::vector<std::string> globals;
+    // interned names of all global symbols
+    std::unordered_set<uint32_t> globals;
 
-    for (auto it = filteredTokens.begin(); it != filteredTokens.end(); /* manual increment */)
+    // strip global/extern lines in one pass, writing the remaining tokens to the front of the stream
+    size_t write = 0;
+    for (size_t read = 0; read < filteredTokens.size(); /* manual increment */)
     {
         bool hasOpeningBracket = false;
-        bool hasClosingBracket = false;
 
-        if (it->type == Token::Type::Bracket && it->value == "[")
+        if (filteredTokens.type(read) == Token::Type::Bracket && filteredTokens[read].value == "[")
         {
-            auto next = std::next(it);
-            if (next != filteredTokens.end())
+            size_t next = read + 1;
+            if (next < filteredTokens.size())
             {
-                const std::string val = toLower(next->value);
-                if (val == "global" || val == "extern")
+                const Token::Token val = filteredTokens[next];
+                if (equalsIgnoreCase(val.value, "global") || equalsIgnoreCase(val.value, "extern"))
                 {
                     hasOpeningBracket = true;
-                    it = filteredTokens.erase(it);
+                    read++;
                 }
             }
         }
 
-        const std::string lowerVal = toLower(it->value);
+        const std::string_view value = filteredTokens[read].value;
+        const bool isGlobal = equalsIgnoreCase(value, "global");
 
-        if (lowerVal == "global" || lowerVal == "extern")
+        if (isGlobal || equalsIgnoreCase(value, "extern"))
         {
             // Get the next token (the symbol name)
-            auto next = std::next(it);
-            if (next != filteredTokens.end())
+            size_t next = read + 1;
+            if (next < filteredTokens.size())
             {
-                if (lowerVal == "global")
-                    globals.push_back(next->value);
+                if (isGlobal)
+                    globals.insert(filteredTokens[next].lexeme);
                 else
                 {
-                    Token::Token externToken(Token::Type::ExternLabel, next->value, next->line, next->column, next->file);
-                    it = filteredTokens.insert(it, externToken);
-                    it++;
+                    filteredTokens.move(next, write);
+                    filteredTokens.setType(write, Token::Type::ExternLabel);
+                    write++;
                 }
             }
 
-            // remove "global"/"extern"
-            it = filteredTokens.erase(it);
+            // skip "global"/"extern"
+            read++;
 
-            // remove symbol
-            if (it != filteredTokens.end())
-                it = filteredTokens.erase(it);
+            // skip symbol
+            if (read < filteredTokens.size())
+                read++;
 
-            // remove ']' if it started with '['
+            // skip ']' if it started with '['
             if (hasOpeningBracket)
             {
-                if (it == filteredTokens.end() || it->type != Token::Type::Bracket || it->value != "]")
-                    throw Exception::SyntaxError("Missing closing ']' after '[global ...' or '[extern ...'", it->line, it->column);
-                it = filteredTokens.erase(it);
+                if (read >= filteredTokens.size() || filteredTokens.type(read) != Token::Type::Bracket || filteredTokens[read].value != "]")
+                {
+                    const Token::Token last = filteredTokens[std::min(read, filteredTokens.size() - 1)];
+                    throw Exception::SyntaxError("Missing closing ']' after '[global ...' or '[extern ...'", last.line, last.column);
+                }
+                read++;
             }
             else
             {
                 /* TODO: think about it
-                if (it != filteredTokens.end() && it->type == Token::Type::Bracket && it->value == "]")
-                    throw Exception::SyntaxError("Unexpected closing ']' after directive", it->line, it->column);
+                if (read < filteredTokens.size() && filteredTokens.type(read) == Token::Type::Bracket && filteredTokens[read].value == "]")
+                    throw Exception::SyntaxError("Unexpected closing ']' after directive", filteredTokens[read].line, filteredTokens[read].column);
                 */
             }
 
-            // Erase tokens until end-of-line
-            while (it != filteredTokens.end() && it->type != Token::Type::EOL)
-            {
-                it = filteredTokens.erase(it);  // erase returns the next valid iterator
-            }
+            // skip tokens until end-of-line
+            while (read < filteredTokens.size() && filteredTokens.type(read) != Token::Type::EOL)
+                read++;
 
-            // Erase the EOL token as well, if present
-            if (it != filteredTokens.end())
-                it = filteredTokens.erase(it);
+            // skip the EOL token as well, if present
+            if (read < filteredTokens.size())
+                read++;
 
-            continue; // Don't increment, already done via erase
+            continue;
         }
 
-        ++it; // only increment if nothing was erased
+        filteredTokens.move(read++, write++);
     }
+    filteredTokens.truncate(write);
 
-    static constexpr std::array<std::string_view, 16> dataDefinitions = {
-        "db", "dw", "dd", "dq", "dt", "do", "dy", "dz",
-        "resb", "resw", "resd", "resq", "rest", "reso", "resy", "resz"
-    };
+    // size in bytes, negative for reservations
+    static constexpr auto dataDefinitions = makeKeywordTable<int8_t>({
+        {"db", 1}, {"dw", 2}, {"dd", 4}, {"dq", 8}, {"dt", 10}, {"do", 16}, {"dy", 32}, {"dz", 64},
+        {"resb", -1}, {"resw", -2}, {"resd", -4}, {"resq", -8}, {"rest", -10}, {"reso", -16}, {"resy", -32}, {"resz", -64}
+    });
+
+    enum class Directive { Section, Bits, Org, Align };
+
+    static constexpr auto directives = makeKeywordTable<Directive>({
+        {"section", Directive::Section}, {"segment", Directive::Section},
+        {"bits", Directive::Bits}, {"org", Directive::Org}, {"align", Directive::Align}
+    });
 
-    static constexpr std::array<std::string_view, 5> directives = {
-        "section", "segment", "bits", "org", "align"
+    enum class MnemonicCategory { Control, Interrupt, Flag, Stack, Data };
+
+    struct Mnemonic
+    {
+        ::x86::Instructions instruction;
+        MnemonicCategory category;
     };
 
+    // every mnemonic in one table, a token costs a single lookup
+    static constexpr auto mnemonics = makeKeywordTable<Mnemonic>({
+        // CONTROL
+        {"nop", {::x86::Instructions::NOP, MnemonicCategory::Control}},
+        {"hlt", {::x86::Instructions::HLT, MnemonicCategory::Control}},
+
+        // INTERRUPT
+        {"int", {::x86::Instructions::INT, MnemonicCategory::Interrupt}},
+        {"iret", {::x86::Instructions::IRET, MnemonicCategory::Interrupt}},
+        {"iretq", {::x86::Instructions::IRETQ, MnemonicCategory::Interrupt}},
+        {"iretd", {::x86::Instructions::IRETD, MnemonicCategory::Interrupt}},
+        {"syscall", {::x86::Instructions::SYSCALL, MnemonicCategory::Interrupt}},
+        {"sysret", {::x86::Instructions::SYSRET, MnemonicCategory::Interrupt}},
+        {"sysenter", {::x86::Instructions::SYSENTER, MnemonicCategory::Interrupt}},
+        {"sysexit", {::x86::Instructions::SYSEXIT, MnemonicCategory::Interrupt}},
+
+        // FLAGS
+        {"clc", {::x86::Instructions::CLC, MnemonicCategory::Flag}},
+        {"stc", {::x86::Instructions::STC, MnemonicCategory::Flag}},
+        {"cmc", {::x86::Instructions::CMC, MnemonicCategory::Flag}},
+        {"cld", {::x86::Instructions::CLD, MnemonicCategory::Flag}},
+        {"std", {::x86::Instructions::STD, MnemonicCategory::Flag}},
+        {"cli", {::x86::Instructions::CLI, MnemonicCategory::Flag}},
+        {"sti", {::x86::Instructions::STI, MnemonicCategory::Flag}},
+        {"lahf", {::x86::Instructions::LAHF, MnemonicCategory::Flag}},
+        {"sahf", {::x86::Instructions::SAHF, MnemonicCategory::Flag}},
+
+        // STACK
+        {"pusha", {::x86::Instructions::PUSHA, MnemonicCategory::Stack}},
+        {"popa", {::x86::Instructions::POPA, MnemonicCategory::Stack}},
+        {"pushad", {::x86::Instructions::PUSHAD, MnemonicCategory::Stack}},
+        {"popad", {::x86::Instructions::POPAD, MnemonicCategory::Stack}},
+        {"pushf", {::x86::Instructions::PUSHF, MnemonicCategory::Stack}},
+        {"popf", {::x86::Instructions::POPF, MnemonicCategory::Stack}},
+        {"pushfd", {::x86::Instructions::PUSHFD, MnemonicCategory::Stack}},
+        {"popfd", {::x86::Instructions::POPFD, MnemonicCategory::Stack}},
+        {"pushfq", {::x86::Instructions::PUSHFQ, MnemonicCategory::Stack}},
+        {"popfq", {::x86::Instructions::POPFQ, MnemonicCategory::Stack}},
+
+        // DATA
+        {"mov", {::x86::Instructions::MOV, MnemonicCategory::Data}}
+    });
+
     ::Parser::Section text;
     text.name = ".text";
     sections.push_back(text);
@@ -166,49 +230,53 @@ void x86::Parser::Parse(const std::vector<Token::Token>& tokens)
     ::Parser::Section* currentSection = &sections.at(0);
     BitMode currentBitMode = bits;
 
+    // collected here and then copied into the arena
+    std::vector<::Parser::ImmediateOperand> operandBuffer;
+    std::vector<::Parser::Immediate> valueBuffer;
+    std::vector<::Parser::Instruction::Operand> instructionOperands;
+
     for (size_t i = 0; i < filteredTokens.size(); i++)
     {
-        const Token::Token& token = filteredTokens[i];
+        const Token::Token token = filteredTokens[i];
         if (token.type == Token::Type::EOL || token.type == Token::Type::_EOF)
             continue;
         
-        const std::string lowerVal = toLower(token.value);
-
         // Constants
-        if (filteredTokens[i + 1].type == Token::Type::Token && filteredTokens[i + 1].value.compare("equ") == 0)
+        if (filteredTokens.type(i + 1) == Token::Type::Token && filteredTokens[i + 1].value.compare("equ") == 0)
         {
             ::Parser::Constant constant;
             constant.lineNumber = token.line;
             constant.column = token.column;
             // TODO: case sensitive
-            constant.name = token.value;
+            constant.name = token.lexeme;
             constant.hasPos = false;
             i += 2;
+            operandBuffer.clear();
 
-            if (std::find(globals.begin(), globals.end(), token.value) != globals.end())
+            if (globals.count(token.lexeme) != 0)
                 constant.isGlobal = true;
             else
                 constant.isGlobal = false;
 
-            while (i < filteredTokens.size() && filteredTokens[i].type != Token::Type::EOL)
+            while (i < filteredTokens.size() && filteredTokens.type(i) != Token::Type::EOL)
             {
-                if (filteredTokens[i].type == Token::Type::Token
-                 || filteredTokens[i].type == Token::Type::Operator
-                 || filteredTokens[i].type == Token::Type::Character
-                 || filteredTokens[i].type == Token::Type::Bracket)
+                if (filteredTokens.type(i) == Token::Type::Token
+                 || filteredTokens.type(i) == Token::Type::Operator
+                 || filteredTokens.type(i) == Token::Type::Character
+                 || filteredTokens.type(i) == Token::Type::Bracket)
                 {
                     while (i < filteredTokens.size() &&
-                           !(filteredTokens[i].type == Token::Type::Comma || filteredTokens[i].type == Token::Type::EOL))
+                           !(filteredTokens.type(i) == Token::Type::Comma || filteredTokens.type(i) == Token::Type::EOL))
                     {
                         ::Parser::ImmediateOperand op = getOperand(filteredTokens[i]);
                         if (std::holds_alternative<::Parser::CurrentPosition>(op) && !constant.hasPos)
                             constant.hasPos = true;
-                        constant.value.operands.push_back(op);
+                        operandBuffer.push_back(op);
                         i++;
                     }
                     i--;
                 }
-                else if (filteredTokens[i].type == Token::Type::String)
+                else if (filteredTokens.type(i) == Token::Type::String)
                 {
                     // TODO
                 }
@@ -218,54 +286,62 @@ void x86::Parser::Parse(const std::vector<Token::Token>& tokens)
                 i++;
             }
 
+            constant.value = makeImmediate(operandBuffer, constant.lineNumber, constant.column);
             currentSection->entries.push_back(constant);
 
             continue;
         }
 
         // times
-        if (token.type == Token::Type::Token && lowerVal.compare("times") == 0)
+        if (token.type == Token::Type::Token && equalsIgnoreCase(token.value, "times"))
         {
             ::Parser::Repetition repetition;
             repetition.lineNumber = token.line;
             repetition.column = token.column;
 
             i++;
-            
-            // TODO: strange way
-            while (i < filteredTokens.size())
+            operandBuffer.clear();
+
+            // the count ends where an operand follows an operand, the rest of the line is what gets repeated
+            bool expectOperand = true;
+            while (i < filteredTokens.size() && filteredTokens.type(i) != Token::Type::EOL)
             {
-                if (filteredTokens[i].type == Token::Type::Token
-                 || filteredTokens[i].type == Token::Type::Operator
-                 || filteredTokens[i].type == Token::Type::Character
-                 || filteredTokens[i].type == Token::Type::Bracket)
+                const Token::Type type = filteredTokens.type(i);
+                if (type == Token::Type::Token || type == Token::Type::Character)
                 {
-                    ::Parser::ImmediateOperand op = getOperand(filteredTokens[i]);
-                    repetition.count.operands.push_back(op);
+                    if (!expectOperand) break;
+                    expectOperand = false;
                 }
+                else if (type == Token::Type::Operator)
+                    expectOperand = true;
+                else if (type == Token::Type::Bracket)
+                    expectOperand = filteredTokens[i].value != ")";
                 else
                     throw Exception::SyntaxError("Unknown value type after 'times'", filteredTokens[i].line, filteredTokens[i].column);
-                
+
+                operandBuffer.push_back(getOperand(filteredTokens[i]));
                 i++;
-                if ( i < filteredTokens.size() && filteredTokens[i].type == Token::Type::EOL)
-                    break;
             }
+
+            if (operandBuffer.empty() || i >= filteredTokens.size() || filteredTokens.type(i) == Token::Type::EOL)
+                throw Exception::SyntaxError("Expected a count and something to repeat after 'times'", repetition.lineNumber, repetition.column);
             i--;
 
+            repetition.count = makeImmediate(operandBuffer, repetition.lineNumber, repetition.column);
             currentSection->entries.push_back(repetition);
             continue;
         }
 
         // Directives
-        if ((token.type == Token::Type::Bracket && token.value == "[" && std::find(directives.begin(), directives.end(), toLower(filteredTokens[i + 1].value)) != directives.end())
-         || std::find(directives.begin(), directives.end(), lowerVal) != directives.end())
+        if ((token.type == Token::Type::Bracket && token.value == "[" && directives.contains(filteredTokens[i + 1].value))
+         || directives.contains(token.value))
         {
             if (token.type == Token::Type::Bracket)
                 i++;
-            const Token::Token& directive = filteredTokens[i];
-            const std::string& lowerDir = toLower(directive.value);
+            const Token::Token directive = filteredTokens[i];
+            const Directive kind = *directives.find(directive.value);
             
-            if (lowerDir.compare("section") == 0 || lowerDir.compare("segment") == 0)
+            if (kind == Directive::Section)
             {
                 // TODO: currently case insensitive
                 std::string name = toLower(filteredTokens[++i].value);
@@ -296,9 +372,9 @@ void x86::Parser::Parse(const std::vector<Token::Token>& tokens)
                     // TODO
                 }
             }
-            else if (lowerDir.compare("bits") == 0)
+            else if (kind == Directive::Bits)
             {
-                std::string bits = filteredTokens[i + 1].value;
+                std::string_view bits = filteredTokens[i + 1].value;
 
                 if (bits.compare(0, 2, "16") == 0)
                     currentBitMode = BitMode::Bits16;
@@ -309,40 +385,43 @@ void x86::Parser::Parse(const std::vector<Token::Token>& tokens)
                 else
                     throw Exception::SyntaxError("Undefined bits", token.line, token.column);
             }
-            else if (lowerDir.compare("org") == 0)
+            else if (kind == Directive::Org)
             {
-                org = filteredTokens[i + 1].value;
+                org = std::string(filteredTokens[i + 1].value);
             }
-            else if (lowerDir.compare("align") == 0)
+            else if (kind == Directive::Align)
             {
                 ::Parser::Alignment align;
+                align.bits = currentBitMode;
                 align.lineNumber = directive.line;
                 align.column = directive.column;
                 i++;
+                operandBuffer.clear();
                 // TODO: strange way
                 while (i < filteredTokens.size())
                 {
-                    if (filteredTokens[i].type == Token::Type::Token
-                    || filteredTokens[i].type == Token::Type::Operator
-                    || filteredTokens[i].type == Token::Type::Character
-                    || filteredTokens[i].type == Token::Type::Bracket)
+                    if (filteredTokens.type(i) == Token::Type::Token
+                    || filteredTokens.type(i) == Token::Type::Operator
+                    || filteredTokens.type(i) == Token::Type::Character
+                    || filteredTokens.type(i) == Token::Type::Bracket)
                     {
                         ::Parser::ImmediateOperand op = getOperand(filteredTokens[i]);
-                        align.align.operands.push_back(op);
+                        operandBuffer.push_back(op);
                     }
                     else
                         throw Exception::SyntaxError("Unknown value type after 'align'", filteredTokens[i].line, filteredTokens[i].column);
                     
                     i++;
-                    if ( i < filteredTokens.size() && filteredTokens[i].type == Token::Type::EOL)
+                    if ( i < filteredTokens.size() && filteredTokens.type(i) == Token::Type::EOL)
                         break;
                 }
                 i--;
 
+                align.align = makeImmediate(operandBuffer, align.lineNumber, align.column);
                 currentSection->entries.push_back(align);
             }
 
-            while (i < filteredTokens.size() && filteredTokens[i].type != Token::Type::EOL)
+            while (i < filteredTokens.size() && filteredTokens.type(i) != Token::Type::EOL)
                 i++;
             continue;
         }
@@ -350,7 +429,7 @@ void x86::Parser::Parse(const std::vector<Token::Token>& tokens)
         if (token.type == Token::Type::ExternLabel)
         {
             ::Parser::Label label;
-            label.name = token.value;
+            label.name = token.lexeme;
             label.lineNumber = token.line;
             label.column = token.column;
             label.isExtern = true;
@@ -362,83 +441,63 @@ void x86::Parser::Parse(const std::vector<Token::Token>& tokens)
 
         // Labels
         if (token.type == Token::Type::Token &&
-           ((filteredTokens[i + 1].type == Token::Type::Punctuation && filteredTokens[i + 1].value == ":" && /*TODO: not segment:offset*/ ::x86::registers.find(token.value) == ::x86::registers.end())
-         || (filteredTokens[i + 1].type == Token::Type::Token && std::find(dataDefinitions.begin(), dataDefinitions.end(), toLower(filteredTokens[i + 1].value)) != dataDefinitions.end())))
+           ((filteredTokens.type(i + 1) == Token::Type::Punctuation && filteredTokens[i + 1].value == ":" && /*TODO: not segment:offset*/ !::x86::registers.contains(token.value))
+         || (filteredTokens.type(i + 1) == Token::Type::Token && dataDefinitions.contains(filteredTokens[i + 1].value))))
         {
             ::Parser::Label label;
-            label.name = token.value;
+            label.name = token.lexeme;
             label.lineNumber = token.line;
             label.column = token.column;
             label.isExtern = false;
 
-            if (std::find(globals.begin(), globals.end(), token.value) != globals.end())
+            if (globals.count(token.lexeme) != 0)
                 label.isGlobal = true;
             else
                 label.isGlobal = false;
 
             currentSection->entries.push_back(label);
 
-            if (filteredTokens[i + 1].type == Token::Type::Punctuation && filteredTokens[i + 1].value == ":")
+            if (filteredTokens.type(i + 1) == Token::Type::Punctuation && filteredTokens[i + 1].value == ":")
                 i++;
             continue;
         }
 
         // Data
-        if (token.type == Token::Type::Token && std::find(dataDefinitions.begin(), dataDefinitions.end(), lowerVal) != dataDefinitions.end())
+        const int8_t* dataSize = token.type == Token::Type::Token ? dataDefinitions.find(token.value) : nullptr;
+        if (dataSize)
         {
             ::Parser::DataDefinition data;
-            char cSize = '\0';
-            if (lowerVal.compare(0, 3, "res") == 0)
-            {
-                data.reserved = true;
-                cSize = lowerVal[3];
-            }
-            else if (lowerVal[0] == 'd')
-            {
-                data.reserved = false;
-                cSize = lowerVal[1];
-            }
+            data.reserved = *dataSize < 0;
+            data.size = static_cast<size_t>(*dataSize < 0 ? -*dataSize : *dataSize);
 
             data.lineNumber = token.line;
             data.column = token.column;
 
-            switch (cSize)
-            {
-                case 'b': data.size = 1; break;
-                case 'w': data.size = 2; break;
-                case 'd': data.size = 4; break;
-                case 'q': data.size = 8; break;
-                case 't': data.size = 10; break;
-                case 'o': data.size = 16; break;
-                case 'y': data.size = 32; break;
-                case 'z': data.size = 64; break;
-                default: throw Exception::InternalError("Unknown size suffix", token.line, token.column);
-            }
-
             i++;
-            while (i < filteredTokens.size() && filteredTokens[i].type != Token::Type::EOL)
+            valueBuffer.clear();
+            while (i < filteredTokens.size() && filteredTokens.type(i) != Token::Type::EOL)
             {
-                if (filteredTokens[i].type == Token::Type::Token
-                 || filteredTokens[i].type == Token::Type::Operator
-                 || filteredTokens[i].type == Token::Type::Character
-                 || filteredTokens[i].type == Token::Type::Bracket)
+                if (filteredTokens.type(i) == Token::Type::Token
+                 || filteredTokens.type(i) == Token::Type::Operator
+                 || filteredTokens.type(i) == Token::Type::Character
+                 || filteredTokens.type(i) == Token::Type::Bracket)
                 {
-                    ::Parser::Immediate val;
-                    
+                    operandBuffer.clear();
+
                     while (i < filteredTokens.size() &&
-                           !(filteredTokens[i].type == Token::Type::Comma || filteredTokens[i].type == Token::Type::EOL))
+                           !(filteredTokens.type(i) == Token::Type::Comma || filteredTokens.type(i) == Token::Type::EOL))
                     {
                         ::Parser::ImmediateOperand op = getOperand(filteredTokens[i]);
-                        val.operands.push_back(op);
+                        operandBuffer.push_back(op);
                         i++;
                     }
                     i--;
 
-                    data.values.push_back(val);
+                    valueBuffer.push_back(makeImmediate(operandBuffer, data.lineNumber, data.column));
                 }
-                else if (filteredTokens[i].type == Token::Type::String)
+                else if (filteredTokens.type(i) == Token::Type::String)
                 {
-                    const std::string& val = filteredTokens[i].value;
+                    std::string_view val = filteredTokens[i].value;
                     size_t len = val.size();
 
                     for (size_t pos = 0; pos < len; pos += data.size)
@@ -458,13 +517,11 @@ void x86::Parser::Parse(const std::vector<Token::Token>& tokens)
                             }
                         }
 
-                        ::Parser::Immediate value;
-
                         ::Parser::Integer integer;
                         integer.value = combined;
-                        value.operands.push_back(integer);
+                        operandBuffer.assign(1, integer);
 
-                        data.values.push_back(value);
+                        valueBuffer.push_back(makeImmediate(operandBuffer, data.lineNumber, data.column));
                     }
                 }
                 else
@@ -473,35 +530,31 @@ void x86::Parser::Parse(const std::vector<Token::Token>& tokens)
                 i++;
                 if (i >= filteredTokens.size()) break;
 
-                if (filteredTokens[i].type == Token::Type::Comma)
+                if (filteredTokens.type(i) == Token::Type::Comma)
                 {
                     i++;
                     if (i >= filteredTokens.size())
                         throw Exception::InternalError("Unexpected end after comma", filteredTokens.back().line, filteredTokens.back().column);
                 }
-                else if (filteredTokens[i].type != Token::Type::EOL)
+                else if (filteredTokens.type(i) != Token::Type::EOL)
                 {
                     throw Exception::SyntaxError("Expected comma or end of line after data definition", filteredTokens[i].line, filteredTokens[i].column);
                 }
             }
 
+            data.values = arena.copy(valueBuffer);
             currentSection->entries.push_back(data);
 
             continue;
         }
 
         // Instructions
+        const Mnemonic* mnemonic = mnemonics.find(token.value);
 
         // CONTROL
-        static const std::unordered_map<std::string_view, uint64_t> controlInstructions = {
-            {"nop", ::x86::Instructions::NOP},
-            {"hlt", ::x86::Instructions::HLT}
-        };
-
-        auto it = controlInstructions.find(lowerVal);
-        if (it != controlInstructions.end())
+        if (mnemonic && mnemonic->category == MnemonicCategory::Control)
         {
-            ::Parser::Instruction::Instruction instruction(it->second, currentBitMode, token.line, token.column);
+            ::Parser::Instruction::Instruction instruction(mnemonic->instruction, currentBitMode, token.line, token.column);
             i++;
             switch (instruction.mnemonic)
             {
@@ -512,43 +565,32 @@ void x86::Parser::Parse(const std::vector<Token::Token>& tokens)
                 default:
                     throw Exception::InternalError("Unknown control instruction", token.line, token.column);
             }
-            if (i >= filteredTokens.size() || filteredTokens[i].type != Token::Type::EOL)
-                throw Exception::SyntaxError("Expected end of line after second argument for '" + lowerVal + "'", token.line, token.column);
+            if (i >= filteredTokens.size() || filteredTokens.type(i) != Token::Type::EOL)
+                throw Exception::SyntaxError("Expected end of line after second argument for '" + toLower(token.value) + "'", token.line, token.column);
             
             currentSection->entries.push_back(instruction);
             continue;
         }
 
         // INTERRUPT
-        static const std::unordered_map<std::string_view, uint64_t> interruptInstructions = {
-            {"int", ::x86::Instructions::INT},
-            {"iret", ::x86::Instructions::IRET},
-            {"iretq", ::x86::Instructions::IRETQ},
-            {"iretd", ::x86::Instructions::IRETD},
-            {"syscall", ::x86::Instructions::SYSCALL},
-            {"sysret", x86::Instructions::SYSRET},
-            {"sysenter", x86::Instructions::SYSENTER},
-            {"sysexit", x86::Instructions::SYSEXIT}
-        };
-
-        it = interruptInstructions.find(lowerVal);
-        if (it != interruptInstructions.end())
+        if (mnemonic && mnemonic->category == MnemonicCategory::Interrupt)
         {
-            ::Parser::Instruction::Instruction instruction(it->second, currentBitMode, token.line, token.column);
+            ::Parser::Instruction::Instruction instruction(mnemonic->instruction, currentBitMode, token.line, token.column);
             i++;
             switch (instruction.mnemonic)
             {
                 case ::x86::Instructions::INT:
                 {
                     // TODO: immediate?
-                    ::Parser::Immediate imm;
-                    while (i < filteredTokens.size() && filteredTokens[i].type != Token::Type::EOL)
+                    operandBuffer.clear();
+                    while (i < filteredTokens.size() && filteredTokens.type(i) != Token::Type::EOL)
                     {
                         ::Parser::ImmediateOperand op = getOperand(filteredTokens[i]);
-                        imm.operands.push_back(op);
+                        operandBuffer.push_back(op);
                         i++;
                     }
-                    instruction.operands.push_back(imm);
+                    instructionOperands.assign(1, makeImmediate(operandBuffer, token.line, token.column));
+                    instruction.operands = arena.copy(instructionOperands);
                 } break;
 
                 case x86::Instructions::IRET:
@@ -563,30 +605,17 @@ void x86::Parser::Parse(const std::vector<Token::Token>& tokens)
                 default:
                     throw Exception::InternalError("Unknown interrupt instruction", token.line, token.column);
             }
-            if (i >= filteredTokens.size() || filteredTokens[i].type != Token::Type::EOL)
-                throw Exception::SyntaxError("Expected end of line after second argument for '" + lowerVal + "'", token.line, token.column);
+            if (i >= filteredTokens.size() || filteredTokens.type(i) != Token::Type::EOL)
+                throw Exception::SyntaxError("Expected end of line after second argument for '" + toLower(token.value) + "'", token.line, token.column);
             
             currentSection->entries.push_back(instruction);
             continue;
         }
 
         // FLAGS
-        static const std::unordered_map<std::string_view, uint64_t> flagInstructions = {
-            {"clc", ::x86::Instructions::CLC},
-            {"stc", ::x86::Instructions::STC},
-            {"cmc", ::x86::Instructions::CMC},
-            {"cld", ::x86::Instructions::CLD},
-            {"std", ::x86::Instructions::STD},
-            {"cli", ::x86::Instructions::CLI},
-            {"sti", ::x86::Instructions::STI},
-            {"lahf", ::x86::Instructions::LAHF},
-            {"sahf", ::x86::Instructions::SAHF}
-        };
-
-        it = flagInstructions.find(lowerVal);
-        if (it != flagInstructions.end())
+        if (mnemonic && mnemonic->category == MnemonicCategory::Flag)
         {
-            ::Parser::Instruction::Instruction instruction(it->second, currentBitMode, token.line, token.column);
+            ::Parser::Instruction::Instruction instruction(mnemonic->instruction, currentBitMode, token.line, token.column);
             i++;
             switch (instruction.mnemonic)
             {
@@ -604,31 +633,17 @@ void x86::Parser::Parse(const std::vector<Token::Token>& tokens)
                 default:
                     throw Exception::InternalError("Unknown flag instruction", token.line, token.column);
             }
-            if (i >= filteredTokens.size() || filteredTokens[i].type != Token::Type::EOL)
-                throw Exception::SyntaxError("Expected end of line after second argument for '" + lowerVal + "'", token.line, token.column);
+            if (i >= filteredTokens.size() || filteredTokens.type(i) != Token::Type::EOL)
+                throw Exception::SyntaxError("Expected end of line after second argument for '" + toLower(token.value) + "'", token.line, token.column);
             
             currentSection->entries.push_back(instruction);
             continue;
         }
 
         // STACK
-        static const std::unordered_map<std::string_view, uint64_t> stackInstructions = {
-            {"pusha", ::x86::Instructions::PUSHA},
-            {"popa", ::x86::Instructions::POPA},
-            {"pushad", ::x86::Instructions::PUSHAD},
-            {"popad", ::x86::Instructions::POPAD},
-            {"pushf", ::x86::Instructions::PUSHF},
-            {"popf", ::x86::Instructions::POPF},
-            {"pushfd", ::x86::Instructions::PUSHFD},
-            {"popfd", ::x86::Instructions::POPFD},
-            {"pushfq", ::x86::Instructions::PUSHFQ},
-            {"popfq", ::x86::Instructions::POPFQ}
-        };
-
-        it = stackInstructions.find(lowerVal);
-        if (it != stackInstructions.end())
+        if (mnemonic && mnemonic->category == MnemonicCategory::Stack)
         {
-            ::Parser::Instruction::Instruction instruction(it->second, currentBitMode, token.line, token.column);
+            ::Parser::Instruction::Instruction instruction(mnemonic->instruction, currentBitMode, token.line, token.column);
             i++;
             switch (instruction.mnemonic)
             {
@@ -647,41 +662,37 @@ void x86::Parser::Parse(const std::vector<Token::Token>& tokens)
                 default:
                     throw Exception::InternalError("Unknown stack instruction", token.line, token.column);
             }
-            if (i >= filteredTokens.size() || filteredTokens[i].type != Token::Type::EOL)
-                throw Exception::SyntaxError("Expected end of line after second argument for '" + lowerVal + "'", token.line, token.column);
+            if (i >= filteredTokens.size() || filteredTokens.type(i) != Token::Type::EOL)
+                throw Exception::SyntaxError("Expected end of line after second argument for '" + toLower(token.value) + "'", token.line, token.column);
 
             currentSection->entries.push_back(instruction);
             continue;
         }
 
         // Data
-        static const std::unordered_map<std::string_view, uint64_t> dataInstructions = {
-            {"mov", ::x86::Instructions::MOV}
-        };
-
-        it = dataInstructions.find(lowerVal);
-        if (it != dataInstructions.end())
+        if (mnemonic && mnemonic->category == MnemonicCategory::Data)
         {
-            ::Parser::Instruction::Instruction instruction(it->second, currentBitMode, token.line, token.column);
+            ::Parser::Instruction::Instruction instruction(mnemonic->instruction, currentBitMode, token.line, token.column);
             i++;
             switch (instruction.mnemonic)
             {
                 case ::x86::Instructions::MOV:
                 {
-                    const Token::Token& operand1 = filteredTokens[i];
-                    auto regIt = ::x86::registers.find(operand1.value);
-                    if (regIt != ::x86::registers.end()
-                     && filteredTokens[i + 1].type != Token::Type::Punctuation)
+                    instructionOperands.clear();
+                    const Token::Token operand1 = filteredTokens[i];
+                    const ::x86::Registers* regIt = ::x86::registers.find(operand1.value);
+                    if (regIt
+                     && filteredTokens.type(i + 1) != Token::Type::Punctuation)
                     {
                         // reg
                         ::Parser::Instruction::Register reg;
-                        reg.reg = regIt->second;
-                        instruction.operands.push_back(reg);
+                        reg.reg = *regIt;
+                        instructionOperands.push_back(reg);
                         i++;
                     }
                     else if ((operand1.type == Token::Type::Bracket && operand1.value == "[")
-                        || (regIt != ::x86::registers.end()
-                        && filteredTokens[i + 1].type != Token::Type::Punctuation))
+                        || (regIt
+                        && filteredTokens.type(i + 1) != Token::Type::Punctuation))
                     {
                         // TODO: memory
                     }
@@ -690,47 +701,48 @@ void x86::Parser::Parse(const std::vector<Token::Token>& tokens)
                         // TODO: Error
                     }
 
-                    if (filteredTokens[i].type != Token::Type::Comma)
+                    if (filteredTokens.type(i) != Token::Type::Comma)
                         throw Exception::SyntaxError("Expected ',' after first argument for 'mov'", operand1.line, operand1.column);
                     i++;
 
-                    const Token::Token& operand2 = filteredTokens[i];
+                    const Token::Token operand2 = filteredTokens[i];
                     regIt = ::x86::registers.find(operand2.value);
-                    if (regIt != ::x86::registers.end()
-                    && filteredTokens[i + 1].type != Token::Type::Punctuation)
+                    if (regIt
+                    && filteredTokens.type(i + 1) != Token::Type::Punctuation)
                     {
                         // reg
                         ::Parser::Instruction::Register reg;
-                        reg.reg = regIt->second;
-                        instruction.operands.push_back(reg);
+                        reg.reg = *regIt;
+                        instructionOperands.push_back(reg);
                         i++;
                     }
                     else if ((operand1.type == Token::Type::Bracket && operand1.value == "[")
-                        || (regIt != ::x86::registers.end()
-                        && filteredTokens[i + 1].type == Token::Type::Punctuation))
+                        || (regIt
+                        && filteredTokens.type(i + 1) == Token::Type::Punctuation))
                     {
                         // TODO: memory
                     }
                     else
                     {
                         // TODO: immediate?
-                        ::Parser::Immediate imm;
+                        operandBuffer.clear();
 
-                        while (i < filteredTokens.size() && filteredTokens[i].type != Token::Type::EOL)
+                        while (i < filteredTokens.size() && filteredTokens.type(i) != Token::Type::EOL)
                         {
                             ::Parser::ImmediateOperand op = getOperand(filteredTokens[i]);
-                            imm.operands.push_back(op);
+                            operandBuffer.push_back(op);
                             i++;
                         }
-                        instruction.operands.push_back(imm);
+                        instructionOperands.push_back(makeImmediate(operandBuffer, operand2.line, operand2.column));
                     }
+                    instruction.operands = arena.copy(instructionOperands);
                 } break;
 
                 default:
                     throw Exception::InternalError("Unknown data instruction", token.line, token.column);
             }
-            if (i >= filteredTokens.size() || filteredTokens[i].type != Token::Type::EOL)
-                throw Exception::SyntaxError("Expected end of line after second argument for '" + lowerVal + "'", token.line, token.column);
+            if (i >= filteredTokens.size() || filteredTokens.type(i) != Token::Type::EOL)
+                throw Exception::SyntaxError("Expected end of line after second argument for '" + toLower(token.value) + "'", token.line, token.column);
             
             currentSection->entries.push_back(instruction);
             continue;
@@ -11,7 +11,7 @@ namespace x86
         Parser(const Context& _context, Architecture _arch, BitMode _bits);
         ~Parser() = default;
         
-        void Parse(const std::vector<Token::Token>& tokens) override;
+        void Parse(Token::TokenStream&& tokens) override;
     
     protected:
         ::Parser::Instruction::Register getReg(const Token::Token& token);
@@ -20,9 +20,9 @@ namespace x86
     inline ::Parser::Instruction::Register Parser::getReg(const Token::Token& token)
     {
         ::Parser::Instruction::Register reg;
-        auto it = ::x86::registers.find(token.value);
-        if (it == ::x86::registers.end()) throw Exception::InternalError("Unknown register: " + token.value, token.line, token.column);
-        reg.reg = it->second;
+        const ::x86::Registers* found = ::x86::registers.find(token.value);
+        if (!found) throw Exception::InternalError("Unknown register: " + std::string(token.value), token.line, token.column);
+        reg.reg = *found;
         return reg;
     }
 }
\ No newline at end of file
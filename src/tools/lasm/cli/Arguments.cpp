@@ -7,7 +7,7 @@
 
 void printHelp(const char* name, std::ostream& s)
 {
-    s << "Usage: " << name << " <inputs> (-o <output>) (--arch <x86>) (--format <bin/elf>) (--bits <16/32/64>) (--debug) (--no-preprocess)" << std::endl;
+    s << "Usage: " << name << " <inputs> (-o <output>) (--arch <x86>) (--format <bin/elf>) (--bits <16/32/64>) (--debug) (--no-preprocess) (--sparse)" << std::endl;
 
     s << std::endl << "Flags:" << std::endl;
     s << "> --arch <arch>             Set architecture" << std::endl;
@@ -15,6 +15,7 @@ void printHelp(const char* name, std::ostream& s)
     s << "> --bits <16/32/64>         Set bit mode" << std::endl;
     s << "> --debug                   Print debug information" << std::endl;
     s << "> --no-preprocess           Don't execute the preprocessor" << std::endl;
+    s << "> --sparse                  Leave zero blocks of flat binaries as holes in the output file" << std::endl;
     
 }
 
@@ -166,6 +167,10 @@ bool parseArguments(int argc, const char *argv[],
         {
             preprocess = false;
         }
+        else if (std::strcmp(argv[i], "--sparse") == 0)
+        {
+            context.sparseOutput = true;
+        }
 
         else if (argv[i][0] == '-' && argv[i][1] != '\0')
         {
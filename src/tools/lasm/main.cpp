@@ -2,6 +2,11 @@
 #include <fstream>
 #include <string>
 #include <filesystem>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <exception>
 
 #include <io/file.hpp>
 #include <Architecture.hpp>
@@ -42,6 +47,55 @@ int handleError(const std::exception& e)
     return 1;
 }
 
+// Reads, preprocesses and tokenizes one input file.
+// Preprocessor messages are collected in diagnostics so they can be printed in input order.
+static Token::TokenStream tokenizeFile(Context context, const std::string& inputFile, bool doPreprocess, std::string& diagnostics)
+{
+    context.filename = std::filesystem::path(inputFile).string();
+    std::unique_ptr<InputBuffer> input = std::make_unique<InputBuffer>(inputFile);
+
+    if (doPreprocess)
+    {
+        std::string in_buf(input->view());
+
+        char* out_buf = nullptr;
+        char* err_buf = nullptr;
+
+        std::string cmd = getExecutableDir() + "/lasmp";
+        cmd += " - -o -";
+        int32_t code = run_program(cmd.c_str(), in_buf.c_str(), &out_buf, &err_buf);
+
+        if (code != 0)
+        {
+            if (err_buf)
+            {
+                diagnostics += err_buf;
+                free_c_string(err_buf);
+            }
+            throw Exception::InternalError("Preprocessor failed", -1, -1);
+        }
+
+        std::string preprocessed;
+        if (out_buf)
+        {
+            preprocessed = out_buf;
+            free_c_string(out_buf);
+        }
+
+        if (err_buf)
+        {
+            diagnostics += err_buf;
+            free_c_string(err_buf);
+        }
+
+        input = InputBuffer::fromContent(std::move(preprocessed));
+    }
+
+    Token::Tokenizer tokenizer(context);
+    tokenizer.tokenize(std::move(input));
+    return tokenizer.takeTokens();
+}
+
 int main(int argc, const char *argv[])
 {
     // TODO: remove this once it's finished
@@ -99,61 +153,56 @@ int main(int argc, const char *argv[])
         objectFile = openOstream(outputFile, std::ios::out | std::ios::trunc | std::ios::binary);
 
         tokenizer.clear();
-        for (size_t i = 0; i < inputFiles.size(); i++)
-        {
-            std::istream* file = openIstream(inputFiles[i]);
-            context.filename = std::filesystem::path(inputFiles[i]).string();
-            std::istream* input = file;
 
-            if (doPreprocess)
-            {
-                std::stringstream* preprocessed = new std::stringstream();
-
-                std::string in_buf((std::istreambuf_iterator<char>(*file)),
-                      std::istreambuf_iterator<char>());
-
-                char* out_buf = nullptr;
-                char* err_buf = nullptr;
+        std::vector<Token::TokenStream> streams(inputFiles.size(), Token::TokenStream(&stringPool));
+        std::vector<std::string> diagnostics(inputFiles.size());
+        std::vector<std::exception_ptr> errors(inputFiles.size());
 
-                std::string cmd = getExecutableDir() + "/lasmp";
-                cmd += " - -o -";
-                int32_t code = run_program(cmd.c_str(), in_buf.c_str(), &out_buf, &err_buf);
-
-                if (code != 0)
-                {
-                    if (err_buf)
-                    {
-                        std::cerr << err_buf;
-                        free_c_string(err_buf);
-                    }
-                    throw Exception::InternalError("Preprocessor failed", -1, -1);
-                }
-
-                if (out_buf)
-                {
-                    *preprocessed << out_buf;
-                    free_c_string(out_buf);
-                }
+        auto tokenizeInput = [&](size_t i)
+        {
+            try
+            {
+                streams[i] = tokenizeFile(context, inputFiles[i], doPreprocess, diagnostics[i]);
+            }
+            catch (...)
+            {
+                errors[i] = std::current_exception();
+            }
+        };
 
-                if (err_buf)
+        // every file gets tokenized on its own, on up to one thread per core
+        size_t workerCount = std::min<size_t>(inputFiles.size(), std::max(1u, std::thread::hardware_concurrency()));
+        if (workerCount <= 1)
+        {
+            for (size_t i = 0; i < inputFiles.size(); i++)
+            {
+                tokenizeInput(i);
+                if (errors[i]) break;
+            }
+        }
+        else
+        {
+            std::atomic<size_t> next = 0;
+            std::vector<std::thread> workers;
+            for (size_t w = 0; w < workerCount; w++)
+            {
+                workers.emplace_back([&]()
                 {
-                    std::cerr << err_buf;;
-                    free_c_string(err_buf);
-                }
-
-                if (inputFiles.at(i) != "-")
-                    delete file;
-
-                preprocessed->seekg(0);
-                input = preprocessed;
+                    for (size_t i = next++; i < inputFiles.size(); i = next++)
+                        tokenizeInput(i);
+                });
             }
+            for (std::thread& worker : workers)
+                worker.join();
+        }
 
-            tokenizer.tokenize(input);
-
-            if (input != file)
-                delete input;
-            else if (inputFiles.at(i) != "-")
-                delete file;
+        // merge in input order, the first failing file is reported
+        for (size_t i = 0; i < inputFiles.size(); i++)
+        {
+            std::cerr << diagnostics[i];
+            if (errors[i])
+                std::rethrow_exception(errors[i]);
+            tokenizer.append(std::move(streams[i]));
         }
         if (debug)
             tokenizer.print();
@@ -185,7 +234,7 @@ int main(int argc, const char *argv[])
         if (!parser)
             throw Exception::InternalError("Couldn't get parser", -1, -1);
         
-        parser->Parse(tokenizer.getTokens());
+        parser->Parse(tokenizer.takeTokens());
         if (debug)
             parser->Print();
 
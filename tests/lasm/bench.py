@@ -0,0 +1,65 @@
+from pathlib import Path
+import argparse
+import subprocess
+import tempfile
+import time
+
+# Scaling benchmark for lasm.
+# Generates sources with a growing number of symbols and reports the time per symbol,
+# which should stay roughly constant if lasm scales linearly.
+#
+# Usage: python3 -m tests.lasm.bench [--sizes 1000,2000,...] [--runs 3]
+
+assembler = Path("dist/bin/lasm")
+
+def generate_globals(count: int) -> str:
+    lines = ["section .text"]
+    for i in range(count):
+        lines.append(f"global sym{i}")
+        lines.append(f"extern ext{i}")
+    for i in range(count):
+        lines.append(f"sym{i}:")
+        lines.append("    mov eax, 1")
+    return "\n".join(lines) + "\n"
+
+benchmarks = {
+    "globals": generate_globals
+}
+
+def run(src: Path, out: Path, runs: int) -> float:
+    cmd = [str(assembler), str(src), "--no-preprocess", "--bits", "32", "--format", "elf", "-o", str(out)]
+    best = None
+    for _ in range(runs):
+        start = time.perf_counter()
+        result = subprocess.run(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE)
+        elapsed = time.perf_counter() - start
+        if result.returncode != 0:
+            raise RuntimeError(f"lasm failed on {src}: {result.stderr.decode(errors='replace')}")
+        best = elapsed if best is None else min(best, elapsed)
+    return best
+
+def main():
+    parser = argparse.ArgumentParser(description="lasm scaling benchmark")
+    parser.add_argument("--sizes", default="1000,2000,4000,8000,16000", help="comma separated symbol counts")
+    parser.add_argument("--runs", type=int, default=3, help="runs per size, the fastest is reported")
+    args = parser.parse_args()
+
+    sizes = [int(x) for x in args.sizes.split(",")]
+
+    with tempfile.TemporaryDirectory() as tmp:
+        tmp_dir = Path(tmp)
+        for name, generate in benchmarks.items():
+            print(f"{name}:")
+            first = None
+            for size in sizes:
+                src = tmp_dir / f"{name}-{size}.asm"
+                src.write_text(generate(size))
+                elapsed = run(src, tmp_dir / f"{name}-{size}.o", args.runs)
+
+                per_symbol = elapsed / size
+                if first is None:
+                    first = per_symbol
+                print(f"  {size:>8} symbols: {elapsed:8.3f}s  {per_symbol * 1e6:8.2f}us/symbol  x{per_symbol / first:.2f}")
+
+if __name__ == "__main__":
+    main()
@@ -6,10 +6,11 @@ import subprocess
 logger = logging.getLogger("tests")
 
 def run_lasm(src: Path, dst: Path, logs: Path, debug: bool,
-        arch: Arch, bits: Bits, format: Format) -> tuple[bool, Path]:
+        arch: Arch, bits: Bits, format: Format, extra_args: tuple[str, ...] = ()) -> tuple[bool, Path]:
     assembler = Path("dist/bin/lasm")
     cmd = [str(assembler), str(src)]
     if debug: cmd.append("-d")
+    cmd.extend(extra_args)
 
     arch_str: str
     bits_str: str
@@ -68,3 +69,7 @@ def run_lasm(src: Path, dst: Path, logs: Path, debug: bool,
         result = subprocess.run(cmd, stdout=f, stderr=f)
 
     return (result.returncode == 0, out)
+
+def run_lasm_sparse(src: Path, dst: Path, logs: Path, debug: bool,
+        arch: Arch, bits: Bits, format: Format) -> tuple[bool, Path]:
+    return run_lasm(src, dst, logs, debug, arch, bits, format, extra_args=("--sparse",))
@@ -0,0 +1,19 @@
+; FORMATS: BIN
+; BITS: 16,32,64
+; EXPECT: SUCCESS
+
+; assembled with and without --sparse, both outputs have to be equal
+
+section .text
+    global _start
+
+_start:
+    hlt
+
+section .data
+first db 1
+; whole zero blocks are left as holes
+    times 0x10000 db 0
+second db 2
+; the file keeps its size when it ends in a hole
+    times 0x10000 db 0
@@ -0,0 +1,24 @@
+; FORMATS: BIN,ELF
+; BITS: 16,32,64
+; EXPECT: SUCCESS
+
+section .text
+    global _start
+
+; code is padded with NOPs for the mode at the align
+_start:
+    nop
+    align 16
+    hlt
+
+[bits 16]
+    nop
+    align 8
+    hlt
+
+section .data
+; data is padded with zeros
+first db 1
+    align 8
+second db 2
+    align 4
@@ -0,0 +1,31 @@
+; FORMATS: BIN,ELF
+; BITS: 64
+; EXPECT: SUCCESS
+
+section .text
+    global _start
+
+; every 'mov r64, imm' gets the shortest form its value fits
+_start:
+    mov rax, 0x12345678             ; zero-extended, mov r32, imm32
+    mov rbx, -1                     ; sign-extended, mov r/m64, imm32
+    mov rcx, 0x123456789            ; full 64 bits
+    mov r8, 0xFFFFFFFF              ; largest zero-extended value
+    mov r9, -0x80000000             ; smallest sign-extended value
+
+    ; constants defined after their use
+    mov rdx, LATER
+    mov rsi, distance
+
+    ; relocated labels always keep the full 64 bits
+    mov rdi, _start
+    mov r10, message
+
+    hlt
+
+end:
+distance equ end - _start
+LATER equ 0x1000
+
+section .data
+message db "relaxed", 0
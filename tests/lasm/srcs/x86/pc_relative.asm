@@ -0,0 +1,21 @@
+; FORMATS: ELF
+; BITS: 32,64
+; EXPECT: SUCCESS
+
+section .text
+    global _start
+
+_start:
+    mov eax, first - $
+    mov ebx, second - $
+    hlt
+
+section .rodata
+; every value gets its own field, $ stays the start of the line
+offsets:
+    dd first - $, second - $, first - $
+    dd second - $
+
+section .data
+first db 1
+second db 2
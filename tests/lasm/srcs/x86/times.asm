@@ -0,0 +1,21 @@
+; FORMATS: BIN,ELF
+; BITS: 16,32,64
+; EXPECT: SUCCESS
+
+section .text
+    global _start
+
+_start:
+    times 4 nop
+    hlt
+
+section .data
+header:
+    db 1, 2, 3
+; count depends on the position, pads the header to 16 bytes
+    times 16 - ($ - header) db 0
+
+; every copy gets its own relocation
+table:
+    times 4 dd table
+    times 3 dw 0x1234
@@ -1,5 +1,5 @@
 from tests.lasm.assembler import Format, Bits, Arch, arch_map, bits_map, format_map
-from tests.lasm.lasm import run_lasm
+from tests.lasm.lasm import run_lasm, run_lasm_sparse
 from tests.lasm.nasm import run_nasm
 
 from pathlib import Path
@@ -123,7 +123,7 @@ def check_if_files_equal(p1: Path, p2: Path, blocksize: int = 8192) -> bool:
 def write_cmp_file(cmp_file: Path, content: list[list[Path]]):
     cmp_file.write_text("")
 
-    num_cols = max(len(content) for cmp in content)
+    num_cols = max(len(cmp) for cmp in content)
     col_widths = [0] * num_cols
     for cmp in content:
         for i, cell, in enumerate(cmp):
@@ -139,9 +139,17 @@ def write_cmp_file(cmp_file: Path, content: list[list[Path]]):
 
 assemblers = {
     "lasm": run_lasm,
+    "lasm-sparse": run_lasm_sparse,
     "nasm": run_nasm
 }
 
+# program that has to be installed for each entry in test.info
+executables = {
+    "lasm": "lasm",
+    "lasm-sparse": "lasm",
+    "nasm": "nasm"
+}
+
 def test(dir: Path, log_dir: Path):
     build_dir = dir / "build"
     srcs_dir = dir / "srcs"
@@ -158,7 +166,7 @@ def test(dir: Path, log_dir: Path):
         test_assemblers: list[str] = []
         for test_assembler_raw in test_assemblers_raw:
             if test_assembler_raw in assemblers:
-                if shutil.which(test_assembler_raw):
+                if shutil.which(executables[test_assembler_raw]):
                     test_assemblers.append(test_assembler_raw)
                 else:
                     logger.warning(f"{test_assembler_raw} couldn't be found")